@@ -0,0 +1,386 @@
+// gta7_microbench: times the hot kernels one at a time. It links only
+// gta7_core, the same library the game links, with no window, GL or audio.
+// Each case repeats until a sample lasts --min-ms; the report gives the
+// median of --reps samples as ns/op, heap allocations per op and, on Linux,
+// cycles, instructions and cache misses from perf_event_open.
+// tools/compare_microbench.py diffs two reports.
+
+#include "chunk_mesh.h"
+#include "entity_pool.h"
+#include "memory.h"
+#include "profiler.h"
+#include "sim.h"
+#include "terrain.h"
+#include "terrain_noise.h"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+// Hardware counters for this thread, read as one group so they cover the
+// same interval. Unavailable off Linux, in most VMs, or when
+// perf_event_paranoid forbids it; the report leaves them null then.
+struct PerfCounters {
+    enum { CYCLES, INSTRUCTIONS, CACHE_MISSES, COUNT };
+    int fds[COUNT] = {-1, -1, -1};
+    bool available = false;
+
+    void open();
+    void close();
+    void start();
+    bool stop(uint64_t values[COUNT]);      // false if the group could not be read
+};
+
+#if defined(__linux__)
+void PerfCounters::open() {
+    const uint64_t configs[COUNT] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES};
+    for (int i = 0; i < COUNT; i++) {
+        perf_event_attr attr = {};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = configs[i];
+        attr.disabled = i == 0;             // the leader switches the whole group
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : fds[0], 0);
+        if (fds[i] < 0) {
+            close();
+            return;
+        }
+    }
+    available = true;
+}
+
+void PerfCounters::close() {
+    for (int& fd : fds) {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+    available = false;
+}
+
+void PerfCounters::start() {
+    if (!available) return;
+    ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+bool PerfCounters::stop(uint64_t values[COUNT]) {
+    if (!available) return false;
+    ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    uint64_t group[1 + COUNT];              // member count, then one value each
+    if (read(fds[0], group, sizeof(group)) != (ssize_t)sizeof(group)) return false;
+    for (int i = 0; i < COUNT; i++) values[i] = group[1 + i];
+    return true;
+}
+#else
+void PerfCounters::open() {}
+void PerfCounters::close() {}
+void PerfCounters::start() {}
+bool PerfCounters::stop(uint64_t*) { return false; }
+#endif
+
+struct MicroResult {
+    std::string name;
+    double nsPerOp = 0, opsPerSec = 0, allocsPerOp = 0;
+    bool counters = false;
+    double cyclesPerOp = 0, ipc = 0, cacheMissesPerOp = 0;
+};
+
+struct MicroBench {
+    double minSampleMs = 50.0;
+    int reps = 5;
+    std::string filter;                 // run only cases whose name contains this
+    PerfCounters perf;
+    std::vector<MicroResult> results;
+    volatile float sink = 0.0f;         // cases fold their output in here so it isn't optimized away
+
+    // fn() performs opsPerCall operations of the case
+    template <typename Fn>
+    void run(const std::string& name, size_t opsPerCall, Fn&& fn);
+    bool writeJson(const std::string& path, unsigned int seed) const;
+};
+
+template <typename Fn>
+void MicroBench::run(const std::string& name, size_t opsPerCall, Fn&& fn) {
+    if (!filter.empty() && name.find(filter) == std::string::npos) return;
+    fn();       // first touch: caches, lazy tables, pool growth
+
+    // Calls per sample: doubled until one sample takes minSampleMs
+    size_t calls = 1;
+    while (calls < ((size_t)1 << 30)) {
+        double start = nowMs();
+        for (size_t i = 0; i < calls; i++) fn();
+        if (nowMs() - start >= minSampleMs) break;
+        calls *= 2;
+    }
+
+    std::vector<double> samples;
+    samples.reserve(reps);
+    uint64_t allocs = 0, totals[PerfCounters::COUNT] = {};
+    bool counted = perf.available;
+    for (int r = 0; r < reps; r++) {
+        uint64_t allocsBefore = heapAllocations.load(std::memory_order_relaxed);
+        perf.start();
+        double start = nowMs();
+        for (size_t i = 0; i < calls; i++) fn();
+        double elapsed = nowMs() - start;
+        uint64_t values[PerfCounters::COUNT];
+        if (perf.stop(values)) {
+            for (int c = 0; c < PerfCounters::COUNT; c++) totals[c] += values[c];
+        } else {
+            counted = false;
+        }
+        allocs += heapAllocations.load(std::memory_order_relaxed) - allocsBefore;
+        samples.push_back(elapsed * 1e6 / ((double)calls * opsPerCall));
+    }
+    std::sort(samples.begin(), samples.end());
+
+    MicroResult result;
+    result.name = name;
+    double ops = (double)calls * opsPerCall * reps;
+    result.nsPerOp = samples[samples.size() / 2];
+    result.opsPerSec = result.nsPerOp > 0 ? 1e9 / result.nsPerOp : 0;
+    result.allocsPerOp = allocs / ops;
+    result.counters = counted;
+    if (counted) {
+        result.cyclesPerOp = totals[PerfCounters::CYCLES] / ops;
+        result.ipc = totals[PerfCounters::CYCLES] ? (double)totals[PerfCounters::INSTRUCTIONS] / totals[PerfCounters::CYCLES] : 0;
+        result.cacheMissesPerOp = totals[PerfCounters::CACHE_MISSES] / ops;
+    }
+
+    printf("%-36s %12.2f ns/op %14.0f op/s %9.4f allocs/op", name.c_str(), result.nsPerOp, result.opsPerSec, result.allocsPerOp);
+    if (counted) printf(" %10.1f cyc/op %5.2f IPC %8.3f miss/op", result.cyclesPerOp, result.ipc, result.cacheMissesPerOp);
+    printf("\n");
+    fflush(stdout);
+    results.push_back(result);
+}
+
+bool MicroBench::writeJson(const std::string& path, unsigned int seed) const {
+    std::ofstream out(path);
+    out << "{\n"
+        << "  \"suite\": \"gta7_microbench\",\n"
+        << "  \"seed\": " << seed << ",\n"
+        << "  \"terrain_kernel\": \"" << terrainKernelName(activeTerrainKernel()) << "\",\n"
+        << "  \"hardware_counters\": " << (perf.available ? "true" : "false") << ",\n"
+        << "  \"min_sample_ms\": " << minSampleMs << ",\n"
+        << "  \"reps\": " << reps << ",\n"
+        << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const MicroResult& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"ns_per_op\": " << r.nsPerOp
+            << ", \"ops_per_sec\": " << r.opsPerSec << ", \"allocs_per_op\": " << r.allocsPerOp;
+        if (r.counters) {
+            out << ", \"cycles_per_op\": " << r.cyclesPerOp << ", \"ipc\": " << r.ipc
+                << ", \"cache_misses_per_op\": " << r.cacheMissesPerOp;
+        } else {
+            out << ", \"cycles_per_op\": null, \"ipc\": null, \"cache_misses_per_op\": null";
+        }
+        out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return (bool)out;
+}
+
+void printMicrobenchUsage() {
+    std::cout << "Usage: gta7_microbench [options]\n"
+              << "  --filter TEXT      only cases whose name contains TEXT\n"
+              << "  --min-ms N         minimum length of one sample (default 50)\n"
+              << "  --reps N           samples per case; the median is reported (default 5)\n"
+              << "  --seed N           RNG seed for the query points and scenery (default 1337)\n"
+              << "  --terrain-kernel K kernel for the non-batch cases (default: widest the CPU runs)\n"
+              << "  --out PATH         JSON report (default microbench.json)\n"
+              << "  --help             show this message\n";
+}
+
+int main(int argc, char** argv) {
+    MicroBench bench;
+    std::string outPath = "microbench.json";
+    unsigned int seed = 1337;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool missingValue = false;
+        auto value = [&](const char* name) -> const char* {
+            if (i + 1 < argc) return argv[++i];
+            std::cout << name << " needs a value\n";
+            missingValue = true;
+            return nullptr;
+        };
+        const char* v = nullptr;
+        if (arg == "--help" || arg == "-h") { printMicrobenchUsage(); return 0; }
+        else if (arg == "--filter" && (v = value("--filter"))) bench.filter = v;
+        else if (arg == "--min-ms" && (v = value("--min-ms"))) bench.minSampleMs = std::max(1.0, std::atof(v));
+        else if (arg == "--reps" && (v = value("--reps"))) bench.reps = std::max(1, std::atoi(v));
+        else if (arg == "--seed" && (v = value("--seed"))) seed = (unsigned int)std::stoul(v);
+        else if (arg == "--out" && (v = value("--out"))) outPath = v;
+        else if (arg == "--terrain-kernel" && (v = value("--terrain-kernel"))) {
+            int k = 0;
+            while (k < TERRAIN_KERNEL_COUNT && std::strcmp(v, terrainKernelName((TerrainKernel)k)) != 0) k++;
+            if (k == TERRAIN_KERNEL_COUNT || !terrainKernelSupported((TerrainKernel)k)) {
+                std::cout << "Terrain kernel " << v << " is not available on this build or CPU\n";
+                return 1;
+            }
+            setTerrainKernel((TerrainKernel)k);
+        }
+        else {
+            if (!missingValue) std::cout << "Unknown option: " << arg << "\n";
+            printMicrobenchUsage();
+            return 1;
+        }
+    }
+
+    gen.seed(seed);
+    initTerrainLods();
+    bench.perf.open();
+    const TerrainKernel kernel = activeTerrainKernel();
+    std::cout << "Microbench: median of " << bench.reps << " samples of at least " << bench.minSampleMs << " ms, "
+              << terrainKernelName(kernel) << " terrain kernel, "
+              << (bench.perf.available ? "hardware counters" : "no hardware counters") << "\n";
+
+    // Query points over the area the puddles and buildings spawn in
+    const size_t POINTS = 4096;
+    std::vector<float> xs(POINTS), zs(POINTS), heights(POINTS);
+    std::uniform_real_distribution<float> coord(-100.0f, 100.0f);
+    for (size_t i = 0; i < POINTS; i++) {
+        xs[i] = coord(gen);
+        zs[i] = coord(gen);
+    }
+
+    bench.run("noise", POINTS, [&] {
+        float sum = 0;
+        for (size_t i = 0; i < POINTS; i++) sum += noise(xs[i], zs[i]);
+        bench.sink = bench.sink + sum;
+    });
+    bench.run("terrain_height", POINTS, [&] {
+        float sum = 0;
+        for (size_t i = 0; i < POINTS; i++) sum += getTerrainHeight(xs[i], zs[i]);
+        bench.sink = bench.sink + sum;
+    });
+    for (int k = 0; k < TERRAIN_KERNEL_COUNT; k++) {
+        if (!terrainKernelSupported((TerrainKernel)k)) continue;
+        bench.run(std::string("terrain_height_batch/") + terrainKernelName((TerrainKernel)k), POINTS, [&] {
+            getTerrainHeightBatchWith((TerrainKernel)k, xs.data(), zs.data(), heights.data(), POINTS);
+            bench.sink = bench.sink + heights[POINTS - 1];
+        });
+    }
+
+    // Nothing is streamed in, so each query generates its tile's corners and
+    // checks the puddle grid: the path for anything outside resident chunks
+    for (int count : {20, 200, 2000}) {
+        spawnPuddles(count);
+        bench.run("terrain_info/puddles_" + std::to_string(count), POINTS, [&] {
+            float sum = 0;
+            for (size_t i = 0; i < POINTS; i++) {
+                TerrainInfo info = getTerrainInfo(xs[i], zs[i]);
+                sum += info.height + (float)info.type;
+            }
+            bench.sink = bench.sink + sum;
+        });
+    }
+    spawnPuddles();
+
+    // CPU side of chunk meshing, per LOD, with each batch kernel
+    std::vector<ChunkMesh> meshes(1);
+    LinearArena scratch(CHUNK_SCRATCH_BYTES);
+    for (int k = 0; k < TERRAIN_KERNEL_COUNT; k++) {
+        if (!terrainKernelSupported((TerrainKernel)k)) continue;
+        setTerrainKernel((TerrainKernel)k);
+        for (int lod = 0; lod < LOD_COUNT; lod++) {
+            int chunk = 0;
+            bench.run("chunk_mesh/lod" + std::to_string(lod) + "/" + terrainKernelName((TerrainKernel)k), 1, [&] {
+                chunk = (chunk + 1) & 15;       // a 4x4 block of different chunks
+                buildChunkMesh(chunk & 3, chunk >> 2, lod, meshes[0], scratch);
+                bench.sink = bench.sink + meshes[0].maxHeight;
+            });
+        }
+    }
+    setTerrainKernel(kernel);
+
+    // One player tick from scattered starts: terrain query, handling and
+    // building collision (with slides when blocked)
+    for (int count : {10, 100, 1000}) {
+        spawnBuildings(count);
+        size_t next = 0;
+        bench.run("car_update/buildings_" + std::to_string(count), 1, [&] {
+            car.position = glm::vec3(xs[next] * 0.5f, 0.0f, zs[next] * 0.5f);
+            car.rotation = zs[next];
+            car.speed = 20.0f;
+            next = (next + 1) % POINTS;
+            car.update(SIM_DT, true, false, (next & 1) != 0, false, false);
+            bench.sink = bench.sink + car.position.x;
+        });
+    }
+    spawnBuildings();
+
+    // One AI tick for the whole swarm. Every two simulated seconds the cops
+    // go back to their spawn points so they keep chasing instead of piling up.
+    car = Car();
+    car.position.y = sampleTerrainHeight(0, 0) + 0.5f;
+    flowField.update(car.position);
+    for (int count : {64, 1024, 4096}) {
+        policeCars.clear();
+        for (int i = 0; i < count; i++) spawnPoliceCar();
+        CopPool spawned = policeCars;
+        int ticks = 0;
+        bench.run("police_update/cops_" + std::to_string(count), (size_t)count, [&] {
+            if (++ticks == 240) {
+                for (int c = 0; c < COP_COMPONENTS; c++) policeCars.columns[c] = spawned.columns[c];
+                ticks = 0;
+            }
+            updatePoliceCars(policeCars, 0, policeCars.size(), SIM_DT, car.position);
+            bench.sink = bench.sink + policeCars[COP_X][0];
+        });
+    }
+    policeCars.clear();
+
+    // Integrate, then the compaction pass simulateTick runs. The target is
+    // far away and lifetimes long, so the pool stays full.
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (int count : {1024, 16384, (int)MAX_BULLETS}) {
+        bullets.clear();
+        for (int i = 0; i < count; i++) {
+            size_t b = bullets.add();
+            glm::vec3 pos(coord(gen), 1.0f, coord(gen));
+            glm::vec3 dir = glm::normalize(glm::vec3(unit(gen), unit(gen) * 0.1f, unit(gen)) + glm::vec3(0.0f, 0.0f, 1e-3f));
+            bullets.setVec3(BULLET_X, b, pos);
+            bullets.setVec3(BULLET_VX, b, dir * 30.0f);
+            bullets.setVec3(BULLET_PREV_X, b, pos);
+            bullets[BULLET_LIFETIME][b] = 1e9f;
+        }
+        const glm::vec3 target(1e6f, 0.0f, 1e6f);
+        bench.run("bullets/integrate_compact_" + std::to_string(count), (size_t)count, [&] {
+            int hits = integrateBullets(bullets, 0, bullets.size(), SIM_DT, target);
+            const float* life = bullets[BULLET_LIFETIME];
+            for (size_t i = 0; i < bullets.size();) {
+                if (life[i] <= 0) bullets.swapRemove(i);
+                else i++;
+            }
+            bench.sink = bench.sink + (float)hits;
+        });
+    }
+    bullets.clear();
+
+    bench.perf.close();
+    if (!bench.writeJson(outPath, seed)) {
+        std::cout << "Failed to write " << outPath << "\n";
+        return 1;
+    }
+    std::cout << "Report written to " << outPath << "\n";
+    return 0;
+}
@@ -7,13 +7,38 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <string>
 #include <cmath>
+#include <cstddef>
 #include <random>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdarg>
+#include <fstream>
+#include <iterator>
+#include <cstring>
+#include <cstdlib>
+#include <new>
 
 #ifndef M_PI
     #define M_PI 3.14159265358979323846
 #endif
 
+#include "chunk_mesh.h"
+#include "entity_pool.h"
+#include "log.h"
+#include "memory.h"
+#include "profiler.h"
+#include "sim.h"
+#include "terrain.h"
+#include "terrain_cache.h"
+#include "terrain_noise.h"
 
 #define STB_TRUETYPE_IMPLEMENTATION
 #include "stb_truetype.h"
@@ -22,418 +47,625 @@
 #define MA_ENABLE_MP3
 #include "miniaudio.h"
 
+// ============ PROFILER ============
+// CPU zones, the trace writer and the logger live in src/; GPU pass timing
+// needs the GL context, so it stays here.
 
-// ============ FORWARD DECLARATIONS (BEFORE STRUCTS) ============
+ZoneStats zoneStats;
 
-enum TerrainType {
-    TERRAIN_ROAD,
-    TERRAIN_GRASS,
-    TERRAIN_DIRT,
-    TERRAIN_PUDDLE
-};
+// GL_TIME_ELAPSED around one pass, read back LATENCY frames later so the
+// CPU never blocks on the GPU. Queries cannot nest: time passes, not frames.
+// A result still pending when its query is reused is dropped.
+struct GpuTimer {
+    static const int LATENCY = 2;
+    unsigned int queries[LATENCY] = {};
+    bool pending[LATENCY] = {};
+    int frame = 0;
+    double lastMs = 0.0;        // most recent result
+    bool fresh = false;         // lastMs was collected by the latest end()
+
+    void init() { glGenQueries(LATENCY, queries); }
+
+    void begin() {
+        pending[frame % LATENCY] = false;
+        glBeginQuery(GL_TIME_ELAPSED, queries[frame % LATENCY]);
+    }
 
-struct TerrainInfo {
-    float height;
-    TerrainType type;
+    void end() {
+        glEndQuery(GL_TIME_ELAPSED);
+        pending[frame % LATENCY] = true;
+        frame++;
+        fresh = false;
+
+        int oldest = frame % LATENCY;
+        if (!pending[oldest]) return;
+        GLint available = 0;
+        glGetQueryObjectiv(queries[oldest], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) return;
+
+        GLuint64 elapsedNs = 0;
+        glGetQueryObjectui64v(queries[oldest], GL_QUERY_RESULT, &elapsedNs);
+        pending[oldest] = false;
+        lastMs = elapsedNs / 1e6;
+        fresh = true;
+    }
 };
 
-struct Puddle {
-    glm::vec2 pos;
-    float radius;
+// ============ AUDIO ============
+// Clips are decoded once into memory through the engine's resource manager:
+// the engine loop from enginesound.mp3, and siren, gunshot and impact
+// synthesised at startup (there are no files for them). Each clip owns a
+// fixed set of voices made up front as copies of one decoded sound, so
+// playing never allocates or decodes. The game thread only pushes
+// AudioCommands into a lock-free single-producer ring; the audio thread
+// applies them. A one-shot with no idle voice steals the one farthest from
+// the listener, or is dropped if it is farther away still. Sirens follow
+// the nearest cops.
+
+const int MAX_CLIP_VOICES = 16;
+static const int CLIP_VOICES[CLIP_COUNT] = {6, 16, 4};     // siren voices = sirens heard at once
+static const char* CLIP_NAMES[CLIP_COUNT] = {"gta7:siren", "gta7:gunshot", "gta7:impact"};
+const float AUDIO_MIN_DISTANCE = 6.0f;
+const float AUDIO_MAX_DISTANCE = 180.0f;
+
+enum AudioCommandType {
+    AUDIO_LISTENER,     // position = car, direction = heading
+    AUDIO_ENGINE,       // volume, pitch
+    AUDIO_PLAY,         // clip at position
+    AUDIO_SIREN         // siren voice `voice` at position, or silent
 };
 
-struct Bullet {
-    glm::vec3 pos;
-    glm::vec3 vel;
-    float lifetime;
+struct AudioCommand {
+    AudioCommandType type;
+    AudioClip clip;
+    int voice;
+    bool active;
+    glm::vec3 position;
+    glm::vec3 direction;
+    float volume, pitch;
 };
 
-struct Building {
+struct AudioVoice {
+    ma_sound sound;
     glm::vec3 position;
-    float width, depth, height;
 };
 
+struct AudioSystem {
+    ma_engine engine;
+    ma_sound engineSound;
+    bool ready = false;                         // engine running, commands accepted
+    bool engineLoaded = false;
+    std::vector<float> clipSamples[CLIP_COUNT]; // mono f32, registered with the resource manager
+    ma_sound clipSounds[CLIP_COUNT];            // decoded originals the voices are copied from
+    bool clipRegistered[CLIP_COUNT] = {};       // samples registered with the resource manager
+    bool clipLoaded[CLIP_COUNT] = {};           // clipSounds[c] initialised; its voices may be used
+    int clipVoiceCount[CLIP_COUNT] = {};
+    AudioVoice voices[CLIP_COUNT][MAX_CLIP_VOICES];
+    glm::vec3 listener = glm::vec3(0.0f);       // audio thread
+
+    static const uint32_t QUEUE_CAPACITY = 1024;
+    AudioCommand queue[QUEUE_CAPACITY];
+    std::atomic<uint32_t> head{0}, tail{0};
+    std::atomic<uint32_t> droppedCommands{0};
+    std::atomic<bool> stopping{false};
+    std::thread thread;
+
+    bool init();
+    void shutdown();
+    void send(const AudioCommand& command);     // game thread only
+    void audioLoop();
+    void apply(const AudioCommand& command);
+    void play(AudioClip clip, const glm::vec3& position);
+};
 
-float noise(float x, float z);
-float getTerrainHeight(float x, float z);
-TerrainInfo getTerrainInfo(float x, float z);
+AudioSystem audio;
+float targetVolume = 0.0f;
+float currentVolume = 0.0f;
 
-// ============ GLOBAL VECTORS (MUST BE BEFORE Car STRUCT) ============
-std::vector<Building> buildings;
-std::vector<Puddle> puddles;
-std::vector<Bullet> bullets;
+int framebufferWidth = 1280;
+int framebufferHeight = 720;
+glm::vec3 cameraPos = glm::vec3(0.0f, 5.0f, 10.0f);
+float deltaTime = 0.0f;        // render frame time, clamped to 0.1s
+float simAccumulator = 0.0f;   // unsimulated time carried to the next frame
 
-// Random generator
-std::random_device rd;
-std::mt19937 gen(rd());
+bool showPerfOverlay = false;   // F3 toggles the profiler overlay
+bool headlessMode = false;     // no window or GL context (benchmarks)
+bool gpuTerrainMode = false;   // heights from the vertex shader, no chunk meshes
 
-// ============ NOW CAR STRUCT CAN USE THEM ============
-struct Car {
-    glm::vec3 position = glm::vec3(0, 0, 0);
-    float rotation = 0.0f;
-    float speed = 0.0f;
-    float steerAngle = 0.0f;
-    float driftAngle = 0.0f;
-    bool isDrifting = false;
-    
-    void update(float dt, bool forward, bool backward, bool left, bool right, bool drift) {
-        const float accel = 18.0f;
-        const float brake = 25.0f;
-        const float maxSpeed = 25.0f;
-        const float friction = 4.0f;
-        
-        TerrainInfo info = getTerrainInfo(position.x, position.z);
-        position.y = info.height + 0.5f;
+float fogDensity = 0.0065f;   // clears roughly to the edge of RENDER_DISTANCE
+glm::vec3 fogColor = glm::vec3(0.7f, 0.75f, 0.8f);
 
-        float speedMult = 1.0f;
-        float steerMult = 1.0f;
+// ============ FUNCTION IMPLEMENTATIONS ============
 
-        switch (info.type) {
-            case TERRAIN_ROAD:
-                speedMult = 1.5f;   // 50% faster
-                steerMult = 1.2f;
-                break;
-            case TERRAIN_GRASS:
-                speedMult = 0.5f;   // 50% speed - you'll feel this
-                steerMult = 0.7f;
-                break;
-            case TERRAIN_DIRT:
-                speedMult = 0.3f;   // 30% speed - very slow
-                steerMult = 0.5f;
-                break;
-            case TERRAIN_PUDDLE:
-                speedMult = 0.1f;   // 10% speed - almost stuck
-                steerMult = 0.15f;  // barely steerable
-                drift = true;
-                break;
+// Procedural clips, at the engine's sample rate. Own LCG so the game RNG is untouched.
+static void synthesizeClip(AudioClip clip, uint32_t sampleRate, std::vector<float>& out) {
+    uint32_t noiseState = 0x2545F491u + (uint32_t)clip;
+    auto noise = [&]() {
+        noiseState = noiseState * 1664525u + 1013904223u;
+        return (noiseState >> 8) * (2.0f / 16777216.0f) - 1.0f;
+    };
+    float rate = (float)sampleRate;
+    if (clip == CLIP_SIREN) {
+        // One-second wail, 550-1250 Hz; a whole number of cycles, so it loops cleanly
+        out.resize(sampleRate);
+        double phase = 0.0;
+        for (uint32_t i = 0; i < sampleRate; i++) {
+            float t = i / rate;
+            float freq = 900.0f - 350.0f * std::cos(2.0f * (float)M_PI * t);
+            phase += 2.0 * M_PI * freq / rate;
+            float tone = (float)std::sin(phase);
+            out[i] = 0.35f * (tone + 0.3f * (tone > 0 ? 1.0f : -1.0f));
         }
-
-        static float debugTimer = 0.0f;
-        static TerrainType lastType = TERRAIN_ROAD;
-        debugTimer += dt;
-
-        if (info.type != lastType || debugTimer > 1.0f) {
-            const char* terrainName[] = {"ROAD", "GRASS", "DIRT", "PUDDLE"};
-            std::cout << "Terrain: " << terrainName[info.type] 
-                    << " | Speed Mult: " << speedMult 
-                    << " | Current Speed: " << speed << "\n";
-            lastType = info.type;
-            debugTimer = 0.0f;
+    } else if (clip == CLIP_GUNSHOT) {
+        // Sharp noise crack with a fast decay and a little low-passed body
+        out.resize(sampleRate / 4);
+        float body = 0.0f;
+        for (size_t i = 0; i < out.size(); i++) {
+            float t = i / rate;
+            float n = noise();
+            body += (n - body) * 0.08f;
+            out[i] = (0.6f * n * std::exp(-t * 45.0f) + 1.5f * body * std::exp(-t * 14.0f)) * 0.8f;
         }
-
-        isDrifting = drift;  // Set drift state
-        const float steerSpeed = (drift ? 3.5f : 2.2f) * steerMult;
-
-        if (forward) speed += accel * speedMult * dt;
-        if (backward) speed -= brake * speedMult * dt;
-
-        // Apply terrain-based friction (always, not just when coasting)
-        float terrainFriction = friction * (2.0f - speedMult); 
-
-        if (!forward && !backward) {
-            if (speed > 0) speed -= terrainFriction * dt;
-            if (speed < 0) speed += terrainFriction * dt;
-            if (std::fabs(speed) < 0.1f) speed = 0;
+    } else {
+        // Low thump dropping in pitch, plus a burst of noise
+        out.resize(sampleRate * 3 / 10);
+        double phase = 0.0;
+        for (size_t i = 0; i < out.size(); i++) {
+            float t = i / rate;
+            phase += 2.0 * M_PI * (90.0f - 50.0f * t / 0.3f) / rate;
+            out[i] = 0.9f * (float)std::sin(phase) * std::exp(-t * 10.0f) + 0.3f * noise() * std::exp(-t * 30.0f);
         }
+    }
+}
+
+bool AudioSystem::init() {
+    if (ma_engine_init(NULL, &engine) != MA_SUCCESS) {
+        std::cout << "Failed to initialize audio\n";
+        return false;
+    }
+    ready = true;
 
-        // CRITICAL FIX: Terrain-based max speed
-        float terrainMaxSpeed = maxSpeed * speedMult;
-        speed = glm::clamp(speed, -terrainMaxSpeed * 0.5f, terrainMaxSpeed);
+    if (ma_sound_init_from_file(&engine, "enginesound.mp3", MA_SOUND_FLAG_DECODE | MA_SOUND_FLAG_LOOPING,
+                                NULL, NULL, &engineSound) != MA_SUCCESS) {
+        std::cout << "Failed to load enginesound.mp3\n";
+    } else {
+        ma_sound_set_spatialization_enabled(&engineSound, MA_FALSE);
+        ma_sound_set_volume(&engineSound, 0.0f);
+        ma_sound_start(&engineSound);
+        engineLoaded = true;
+    }
 
-        // CRITICAL FIX: Active speed reduction when over terrain limit
-        if (speed > terrainMaxSpeed) {
-            speed -= (speed - terrainMaxSpeed) * 5.0f * dt; // Quick slowdown
+    ma_resource_manager* resources = ma_engine_get_resource_manager(&engine);
+    uint32_t sampleRate = ma_engine_get_sample_rate(&engine);
+    for (int c = 0; c < CLIP_COUNT; c++) {
+        synthesizeClip((AudioClip)c, sampleRate, clipSamples[c]);
+        clipRegistered[c] = ma_resource_manager_register_decoded_data(resources, CLIP_NAMES[c], clipSamples[c].data(),
+                                                                      clipSamples[c].size(), ma_format_f32, 1,
+                                                                      sampleRate) == MA_SUCCESS;
+        clipLoaded[c] = clipRegistered[c] &&
+                        ma_sound_init_from_file(&engine, CLIP_NAMES[c], MA_SOUND_FLAG_DECODE, NULL, NULL,
+                                                &clipSounds[c]) == MA_SUCCESS;
+        if (!clipLoaded[c]) {
+            std::cout << "Failed to create sound " << CLIP_NAMES[c] << "\n";
+            continue;
         }
-        if (speed < -terrainMaxSpeed * 0.5f) {
-            speed -= (speed + terrainMaxSpeed * 0.5f) * 5.0f * dt;
+        for (int v = 0; v < CLIP_VOICES[c]; v++) {
+            ma_sound& sound = voices[c][v].sound;
+            if (ma_sound_init_copy(&engine, &clipSounds[c], 0, NULL, &sound) != MA_SUCCESS) break;
+            ma_sound_set_attenuation_model(&sound, ma_attenuation_model_inverse);
+            ma_sound_set_min_distance(&sound, AUDIO_MIN_DISTANCE);
+            ma_sound_set_max_distance(&sound, AUDIO_MAX_DISTANCE);
+            ma_sound_set_looping(&sound, c == CLIP_SIREN);
+            ma_sound_set_volume(&sound, c == CLIP_SIREN ? 0.5f : 0.9f);
+            voices[c][v].position = glm::vec3(0.0f);
+            clipVoiceCount[c]++;
         }
+    }
 
+    thread = std::thread([this] { audioLoop(); });
+    return true;
+}
 
+void AudioSystem::shutdown() {
+    if (!ready) return;
+    stopping = true;
+    thread.join();
+    ready = false;
+
+    ma_resource_manager* resources = ma_engine_get_resource_manager(&engine);
+    for (int c = 0; c < CLIP_COUNT; c++) {
+        for (int v = 0; v < clipVoiceCount[c]; v++) ma_sound_uninit(&voices[c][v].sound);
+        if (clipLoaded[c]) ma_sound_uninit(&clipSounds[c]);
+        if (clipRegistered[c]) ma_resource_manager_unregister_data(resources, CLIP_NAMES[c]);
+    }
+    if (engineLoaded) ma_sound_uninit(&engineSound);
+    ma_engine_uninit(&engine);
+}
 
-        if (left) steerAngle = steerSpeed;
-        else if (right) steerAngle = -steerSpeed;
-        else steerAngle = 0;
-
-        if (std::fabs(speed) > 0.1f) {
-            float turnRate = isDrifting ? 0.7f : 1.0f;
-            rotation += steerAngle * dt * (speed / maxSpeed) * turnRate;
-        }
+void AudioSystem::send(const AudioCommand& command) {
+    if (!ready) return;
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= QUEUE_CAPACITY) {
+        droppedCommands.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    queue[h % QUEUE_CAPACITY] = command;
+    head.store(h + 1, std::memory_order_release);
+}
 
-        if (isDrifting) {
-            driftAngle += (steerAngle * 0.3f - driftAngle) * 5.0f * dt;
-        } else {
-            driftAngle *= 0.9f;
-        }
-
-        // Store old position
-        glm::vec3 oldPosition = position;
-
-        // Calculate new position
-        position.x += std::sin(rotation) * speed * dt;
-        position.z += std::cos(rotation) * speed * dt;
-
-        // === BUILDING COLLISION (with car size buffer) ===
-        const float carRadius = 2.5f; // Car's collision radius
-
-        bool collided = false;
-
-        for (const auto& b : buildings) {
-            // Expanded collision box that accounts for car size
-            float minX = b.position.x - b.width/2 - carRadius;
-            float maxX = b.position.x + b.width/2 + carRadius;
-            float minZ = b.position.z - b.depth/2 - carRadius;
-            float maxZ = b.position.z + b.depth/2 + carRadius;
-            
-            // Check if car is in expanded collision zone
-            if (position.x >= minX && position.x <= maxX &&
-                position.z >= minZ && position.z <= maxZ) {
-                
-                // REVERT to old position completely
-                position = oldPosition;
-                
-                // Stop the car
-                speed *= 0.2f;
-                
-                collided = true;
-                std::cout << "BUMPED INTO BUILDING! (at " 
-                        << b.position.x << ", " << b.position.z << ")\n";
-                break;
-            }
+void AudioSystem::audioLoop() {
+    while (!stopping.load(std::memory_order_acquire)) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t h = head.load(std::memory_order_acquire);
+        if (t == h) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            continue;
         }
+        for (; t != h; t++) apply(queue[t % QUEUE_CAPACITY]);
+        tail.store(t, std::memory_order_release);
+    }
+}
 
-        // If we collided, try to slide along the wall instead of full stop
-        if (collided) {
-            // Try moving only in X direction
-            glm::vec3 slideX = oldPosition;
-            slideX.x += std::sin(rotation) * speed * dt;
-            
-            bool canSlideX = true;
-            for (const auto& b : buildings) {
-                float minX = b.position.x - b.width/2 - carRadius;
-                float maxX = b.position.x + b.width/2 + carRadius;
-                float minZ = b.position.z - b.depth/2 - carRadius;
-                float maxZ = b.position.z + b.depth/2 + carRadius;
-                
-                if (slideX.x >= minX && slideX.x <= maxX &&
-                    slideX.z >= minZ && slideX.z <= maxZ) {
-                    canSlideX = false;
-                    break;
-                }
+void AudioSystem::apply(const AudioCommand& command) {
+    switch (command.type) {
+        case AUDIO_LISTENER:
+            listener = command.position;
+            ma_engine_listener_set_position(&engine, 0, command.position.x, command.position.y, command.position.z);
+            ma_engine_listener_set_direction(&engine, 0, command.direction.x, command.direction.y, command.direction.z);
+            break;
+        case AUDIO_ENGINE:
+            if (engineLoaded) {
+                ma_sound_set_volume(&engineSound, command.volume);
+                ma_sound_set_pitch(&engineSound, command.pitch);
             }
-            
-            // Try moving only in Z direction
-            glm::vec3 slideZ = oldPosition;
-            slideZ.z += std::cos(rotation) * speed * dt;
-            
-            bool canSlideZ = true;
-            for (const auto& b : buildings) {
-                float minX = b.position.x - b.width/2 - carRadius;
-                float maxX = b.position.x + b.width/2 + carRadius;
-                float minZ = b.position.z - b.depth/2 - carRadius;
-                float maxZ = b.position.z + b.depth/2 + carRadius;
-                
-                if (slideZ.x >= minX && slideZ.x <= maxX &&
-                    slideZ.z >= minZ && slideZ.z <= maxZ) {
-                    canSlideZ = false;
-                    break;
-                }
+            break;
+        case AUDIO_PLAY:
+            play(command.clip, command.position);
+            break;
+        case AUDIO_SIREN: {
+            if (!clipLoaded[CLIP_SIREN] || command.voice >= clipVoiceCount[CLIP_SIREN]) break;
+            AudioVoice& v = voices[CLIP_SIREN][command.voice];
+            if (command.active) {
+                v.position = command.position;
+                ma_sound_set_position(&v.sound, v.position.x, v.position.y, v.position.z);
+                if (!ma_sound_is_playing(&v.sound)) ma_sound_start(&v.sound);
+            } else if (ma_sound_is_playing(&v.sound)) {
+                ma_sound_stop(&v.sound);
             }
-            
-            // Apply sliding if possible
-            if (canSlideX) position.x = slideX.x;
-            if (canSlideZ) position.z = slideZ.z;
+            break;
         }
+    }
+}
 
-    }     
-};
+void AudioSystem::play(AudioClip clip, const glm::vec3& position) {
+    if (!clipLoaded[clip]) return;
+    AudioVoice* chosen = nullptr;
+    AudioVoice* farthest = nullptr;
+    float farthestDist2 = -1.0f;
+    for (int v = 0; v < clipVoiceCount[clip]; v++) {
+        AudioVoice& voice = voices[clip][v];
+        if (!ma_sound_is_playing(&voice.sound)) {
+            chosen = &voice;
+            break;
+        }
+        glm::vec3 d = voice.position - listener;
+        if (glm::dot(d, d) > farthestDist2) {
+            farthestDist2 = glm::dot(d, d);
+            farthest = &voice;
+        }
+    }
+    if (!chosen) {
+        glm::vec3 d = position - listener;
+        if (!farthest || glm::dot(d, d) >= farthestDist2) return;     // every voice is closer
+        chosen = farthest;
+        ma_sound_stop(&chosen->sound);
+    }
+    chosen->position = position;
+    ma_sound_set_position(&chosen->sound, position.x, position.y, position.z);
+    ma_sound_seek_to_pcm_frame(&chosen->sound, 0);
+    ma_sound_start(&chosen->sound);
+}
 
-struct PoliceCar {
-    glm::vec3 position;
-    float rotation;
-    float speed;
-    
-    void update(float dt, glm::vec3 targetPos) {
-        glm::vec3 toTarget = targetPos - position;
-        float dist = glm::length(toTarget);
-        
-        if (dist > 1.0f) {
-            toTarget = glm::normalize(toTarget);
-            
-            float targetRot = atan2(toTarget.x, toTarget.z);
-            float rotDiff = targetRot - rotation;
-            
-            while (rotDiff > M_PI) rotDiff -= 2 * M_PI;
-            while (rotDiff < -M_PI) rotDiff += 2 * M_PI;
-            
-            rotation += rotDiff * 3.0f * dt;
-            
-            float targetSpeed = dist > 30.0f ? 18.0f : 12.0f;
-            speed += (targetSpeed - speed) * 2.0f * dt;
+// After the frame's sim ticks: plays the sounds they raised
+void flushSounds() {
+    if (audio.ready) {
+        for (int i = 0; i < soundEventCount; i++) {
+            AudioCommand command = {};
+            command.type = AUDIO_PLAY;
+            command.clip = soundEvents[i].clip;
+            command.position = soundEvents[i].position;
+            audio.send(command);
         }
-        
-        position.x += sin(rotation) * speed * dt;
-        position.z += cos(rotation) * speed * dt;
-        position.y = getTerrainHeight(position.x, position.z) + 0.5f;
     }
-};
+    soundEventCount = 0;
+}
 
-std::vector<PoliceCar> policeCars;
+// Once per frame: listener, engine note, and sirens on the nearest cops
+void updateAudio(float dt) {
+    if (!audio.ready) return;
+
+    AudioCommand listener = {};
+    listener.type = AUDIO_LISTENER;
+    listener.position = car.position;
+    listener.direction = glm::vec3(sin(car.rotation), 0.0f, cos(car.rotation));
+    audio.send(listener);
+
+    // Engine pitch follows speed as a stand-in for RPM
+    currentVolume += (targetVolume - currentVolume) * (1.0f - expf(-2.0f * dt));
+    AudioCommand engineNote = {};
+    engineNote.type = AUDIO_ENGINE;
+    engineNote.volume = currentVolume;
+    engineNote.pitch = 0.75f + 0.85f * std::min(std::fabs(car.speed) / 25.0f, 1.2f);
+    audio.send(engineNote);
+
+    size_t copCount = policeCars.size();
+    auto* nearest = frameArena.allocArray<std::pair<float, uint32_t>>(copCount);
+    for (size_t i = 0; i < copCount; i++) {
+        glm::vec3 d = policeCars.vec3(COP_X, i) - car.position;
+        nearest[i] = {glm::dot(d, d), (uint32_t)i};
+    }
+    size_t sirens = std::min(copCount, (size_t)CLIP_VOICES[CLIP_SIREN]);
+    std::nth_element(nearest, nearest + sirens, nearest + copCount);
+    for (int v = 0; v < CLIP_VOICES[CLIP_SIREN]; v++) {
+        AudioCommand siren = {};
+        siren.type = AUDIO_SIREN;
+        siren.voice = v;
+        siren.active = (size_t)v < sirens;
+        if (siren.active) siren.position = policeCars.vec3(COP_X, nearest[v].second);
+        audio.send(siren);
+    }
+}
 
-// Audio
-ma_engine engine;
-ma_sound engineSound;
-bool isEngineLoaded = false;
-float targetVolume = 0.0f;
-float currentVolume = 0.0f;
+// ============ CHUNK BUFFERS ============
+// GL side of the terrain. Chunk meshes are built off-thread (src/chunk_mesh.h)
+// and uploaded here, a few per frame, within CHUNK_UPLOAD_BUDGET_MS.
 
-Car car;
+const double CHUNK_UPLOAD_BUDGET_MS = 2.0;
 
-// Game state
-float survivalTime = 0.0f;
-float highScore = 0.0f;
-bool gameStarted = false;
-float spawnTimer = 0.0f;
-float shootTimer = 0.0f;
+std::vector<int> uploadQueue;                   // finished records, over last frame's budget
 
-int framebufferWidth = 1280;
-int framebufferHeight = 720;
-glm::vec3 cameraPos = glm::vec3(0.0f, 5.0f, 10.0f);
-float deltaTime = 0.0f;
+unsigned int terrainIndexEBO = 0;
 
-float fogDensity = 0.02f;
-glm::vec3 fogColor = glm::vec3(0.7f, 0.75f, 0.8f);
+// Per-draw terrain data, vertex attributes 2 and 3. With multi-draw
+// indirect it is a per-instance array picked by each command's
+// baseInstance; otherwise each draw sets it as constant attributes.
+struct ChunkDraw {
+    float originX, originZ;
+    float lodStep;
+    float morphEnd;     // chunks from the car where the morph completes
+    GLint vertexBase;   // the command's baseVertex, which the shader subtracts from gl_VertexID
+};
 
-// ============ FUNCTION IMPLEMENTATIONS ============
+// Layout fixed by GL_ARB_draw_indirect
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
 
-float noise(float x, float z) {
-    int xi = (int)floor(x);
-    int zi = (int)floor(z);
-    float xf = x - xi;
-    float zf = z - zi;
-    
-    auto hash = [](int a, int b) {
-        int h = a * 374761393 + b * 668265263;
-        h = (h ^ (h >> 13)) * 1274126177;
-        return (h & 0x7fffffff) / (float)0x7fffffff;
-    };
-    
-    float a = hash(xi, zi);
-    float b = hash(xi + 1, zi);
-    float c = hash(xi, zi + 1);
-    float d = hash(xi + 1, zi + 1);
-    
-    auto smoothstep = [](float t) { return t * t * (3.0f - 2.0f * t); };
-    float u = smoothstep(xf);
-    float v = smoothstep(zf);
-    
-    return a * (1-u) * (1-v) + b * u * (1-v) + c * (1-u) * v + d * u * v;
-}
+bool terrainMultiDraw = false;      // GL_ARB_multi_draw_indirect + GL_ARB_base_instance
+unsigned int terrainDrawVBO = 0;    // ChunkDraw per command, multi-draw only
 
-float getTerrainHeight(float x, float z) {
-    float height = 0;
-    float scale = 0.02f;
-    height += noise(x * scale, z * scale) * 5.0f;
-    height += noise(x * scale * 2, z * scale * 2) * 2.0f;
-    height += noise(x * scale * 4, z * scale * 4) * 0.5f;
-    return height;
-}
+// All chunk meshes share one VBO cut into fixed slots, each big enough for
+// a LOD 0 mesh, and one VAO; draws select a slot with a base vertex. It is
+// sized for the whole keep window at startup, so streaming never creates
+// or deletes GL objects. Which slots are free is tracked by chunkSlots.
+struct ChunkBufferPool {
+    unsigned int VAO = 0, VBO = 0;
 
-TerrainInfo getTerrainInfo(float x, float z) {
-    float height = getTerrainHeight(x, z);
+    void init(int slotCount);
+    void upload(int slot, const float* vertices, int vertexCount);
+};
 
-    TerrainType type;
-    if (height < 0.5f) {
-        type = TERRAIN_ROAD;
-    } else if (height < 3.0f) {
-        type = TERRAIN_GRASS;
-    } else {
-        type = TERRAIN_DIRT;
+ChunkBufferPool chunkPool;
+
+// ============ CULLING ============
+
+// View frustum planes pulled from projection * view (Gribb/Hartmann).
+// Plane normals point inward; a box is culled when it is fully behind one.
+struct Frustum {
+    glm::vec4 planes[6];
+
+    void extract(const glm::mat4& m) {
+        glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+        planes[0] = row3 + row0;    // left
+        planes[1] = row3 - row0;    // right
+        planes[2] = row3 + row1;    // bottom
+        planes[3] = row3 - row1;    // top
+        planes[4] = row3 + row2;    // near
+        planes[5] = row3 - row2;    // far
+        for (auto& p : planes) {
+            p = p / glm::length(glm::vec3(p.x, p.y, p.z));
+        }
     }
 
-    for (const auto& p : puddles) {
-        if (glm::length(glm::vec2(x, z) - p.pos) < p.radius) {
-            type = TERRAIN_PUDDLE;
-            break;
+    bool intersectsAABB(const glm::vec3& mn, const glm::vec3& mx) const {
+        for (const auto& p : planes) {
+            // Corner furthest along the plane normal
+            glm::vec3 v(p.x >= 0 ? mx.x : mn.x, p.y >= 0 ? mx.y : mn.y, p.z >= 0 ? mx.z : mn.z);
+            if (p.x * v.x + p.y * v.y + p.z * v.z + p.w < 0) return false;
         }
+        return true;
     }
+};
 
-    return {height, type};
-}
+// Objects further than the terrain window are never drawn
+const float MAX_DRAW_DISTANCE = RENDER_DISTANCE * CHUNK_SIZE * TILE_SIZE;
+
+struct FrameStats {
+    int chunksDrawn = 0, chunksCulled = 0;
+    int terrainTriangles = 0;
+    int terrainDrawCalls = 0;
+    int objectsDrawn = 0, objectsCulled = 0;
+    int objectDrawCalls = 0;
+    int programChanges = 0, vaoChanges = 0, blendChanges = 0;
+    int particlesSpawned = 0;
+};
 
-void spawnBuildings() {
-    buildings.clear();
-    std::uniform_real_distribution<> x(-50, 50);
-    std::uniform_real_distribution<> z(-50, 50);
-    for (int i = 0; i < 10; i++) {
-        Building b;
-        b.position = glm::vec3(x(gen), 0, z(gen));
-        b.width = 8.0f;
-        b.depth = 8.0f;
-        b.height = 12.0f;
-        b.position.y = getTerrainInfo(b.position.x, b.position.z).height;
-        buildings.push_back(b);
-    }
-}
+FrameStats frameStats;
 
-void spawnPuddles() {
-    puddles.clear();
-    std::uniform_real_distribution<> dist(-100, 100);
-    std::uniform_real_distribution<> rad(3, 8);
-    for (int i = 0; i < 20; i++) {
-        Puddle p;
-        p.pos = glm::vec2(dist(gen), dist(gen));
-        p.radius = rad(gen);
-        puddles.push_back(p);
+// World AABB of the unit car cube ([-1,1] x [0,1] x [-2,2]) under a model matrix
+bool isCubeVisible(const Frustum& frustum, const glm::mat4& model) {
+    glm::vec3 center = glm::vec3(model * glm::vec4(0.0f, 0.5f, 0.0f, 1.0f));
+    glm::vec3 extent(0.0f);
+    const glm::vec3 half(1.0f, 0.5f, 2.0f);
+    for (int axis = 0; axis < 3; axis++) {
+        extent += glm::abs(glm::vec3(model[axis])) * half[axis];
     }
-}
 
-void spawnPoliceCar() {
-    PoliceCar cop;
-    std::uniform_real_distribution<> angle(0, 2 * M_PI);
-    float a = angle(gen);
-    float spawnDist = 60.0f;
-    cop.position = car.position + glm::vec3(cos(a) * spawnDist, 0, sin(a) * spawnDist);
-    cop.position.y = getTerrainHeight(cop.position.x, cop.position.z) + 0.5f;
-    cop.rotation = 0;
-    cop.speed = 0;
-    policeCars.push_back(cop);
+    glm::vec3 toCenter = center - cameraPos;
+    bool visible = glm::length(toCenter) - glm::length(extent) <= MAX_DRAW_DISTANCE &&
+                   frustum.intersectsAABB(center - extent, center + extent);
+    if (visible) frameStats.objectsDrawn++;
+    else frameStats.objectsCulled++;
+    return visible;
 }
 
-// ============ CHUNK SYSTEM ============
-
-const int CHUNK_SIZE = 32;
-const float TILE_SIZE = 2.0f;
-const int RENDER_DISTANCE = 5;
-
-struct Chunk {
-    int x, z;
-    unsigned int VAO, VBO, EBO;
-    int indexCount;
-};
-
-std::map<std::pair<int, int>, Chunk> chunks;
+bool isChunkVisible(const Frustum& frustum, const Chunk& chunk, int playerChunkX, int playerChunkZ) {
+    const float chunkWorld = CHUNK_SIZE * TILE_SIZE;
+    bool visible = abs(chunk.x - playerChunkX) <= RENDER_DISTANCE &&
+                   abs(chunk.z - playerChunkZ) <= RENDER_DISTANCE &&
+                   frustum.intersectsAABB(glm::vec3(chunk.x * chunkWorld, chunk.minHeight, chunk.z * chunkWorld),
+                                          glm::vec3((chunk.x + 1) * chunkWorld, chunk.maxHeight, (chunk.z + 1) * chunkWorld));
+    if (visible) {
+        frameStats.chunksDrawn++;
+        frameStats.terrainTriangles += terrainLods[chunk.lod].indexCount / 3;
+    } else {
+        frameStats.chunksCulled++;
+    }
+    return visible;
+}
 
 // ============ SHADERS ============
 
+// CHUNK_SIZE, TILE_SIZE, SKIRT_DEPTH and LOD_MORPH_WIDTH mirror the chunk constants.
+// With GPU_TERRAIN defined the shader evaluates getTerrainHeight() itself and
+// chunks need no vertex data; otherwise it reads the worker-built mesh.
 const char* vertexShaderSource = R"(
 #version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aColor;
+#ifndef GPU_TERRAIN
+layout (location = 0) in float aHeight;
+layout (location = 1) in float aMorphHeight;   // coarser LOD's surface here
+#endif
+layout (location = 2) in vec4 aChunk;           // origin XZ, LOD step, morph end (ChunkDraw)
+layout (location = 3) in int aVertexBase;       // the draw's base vertex, which gl_VertexID includes
 
 out vec3 Color;
 out float Height;
 out vec3 FragPos;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPos;
+    float fogDensity;
+    vec3 fogColor;
+};
+
+uniform vec2 lodFocus;      // car XZ; LOD rings are centred on it
+
+const int CHUNK_SIZE = 32;
+const float TILE_SIZE = 2.0;
+const float SKIRT_DEPTH = 4.0;
+const float LOD_MORPH_WIDTH = 1.0;
+
+// Unpacked from aChunk at the top of main()
+vec2 chunkOrigin;
+int lodStep;
+
+#ifdef GPU_TERRAIN
+// Ports of latticeHash(), noise() and getTerrainHeight(). Integer math
+// matches exactly; float results agree to rounding, which only moves the
+// drawn surface, never the physics.
+int latticeHash(int a, int b) {
+    int h = int(uint(a) * 374761393u + uint(b) * 668265263u);
+    h = int(uint(h ^ (h >> 13)) * 1274126177u);
+    return h & 0x7fffffff;
+}
+
+float latticeValue(ivec2 p) {
+    return float(latticeHash(p.x, p.y)) / 2147483647.0;
+}
+
+float noise(vec2 p) {
+    vec2 cell = floor(p);
+    ivec2 i = ivec2(cell);
+    vec2 f = p - cell;
+    float a = latticeValue(i);
+    float b = latticeValue(i + ivec2(1, 0));
+    float c = latticeValue(i + ivec2(0, 1));
+    float d = latticeValue(i + ivec2(1, 1));
+    vec2 s = f * f * (3.0 - 2.0 * f);
+    return a * (1.0 - s.x) * (1.0 - s.y) + b * s.x * (1.0 - s.y) + c * (1.0 - s.x) * s.y + d * s.x * s.y;
+}
+
+float terrainHeight(vec2 p) {
+    const float scale = 0.02;
+    return noise(p * scale) * 5.0 + noise(p * scale * 2.0) * 2.0 + noise(p * scale * 4.0) * 0.5;
+}
+
+float gridHeight(vec2 grid) {
+    return terrainHeight(chunkOrigin + grid * float(lodStep) * TILE_SIZE);
+}
+
+// Same rule as morphHeight() in buildChunkMesh()
+float morphTarget(vec2 grid, float h) {
+    ivec2 g = ivec2(grid);
+    bool oddX = (g.x & 1) == 1, oddZ = (g.y & 1) == 1;
+    if (oddX && oddZ) return (gridHeight(grid + vec2(1, -1)) + gridHeight(grid + vec2(-1, 1))) * 0.5;
+    if (oddX) return (gridHeight(grid - vec2(1, 0)) + gridHeight(grid + vec2(1, 0))) * 0.5;
+    if (oddZ) return (gridHeight(grid - vec2(0, 1)) + gridHeight(grid + vec2(0, 1))) * 0.5;
+    return h;
+}
+#endif
+
+vec3 terrainColor(float h) {
+    if (h < 0.5) return vec3(0.3, 0.3, 0.3);        // road
+    if (h < 3.0) return vec3(0.35, 0.55, 0.25);     // grass
+    return vec3(0.45, 0.5, 0.45);                  // dirt
+}
+
+// Same walk as skirtGridPos()
+vec2 skirtGrid(int k, int tiles) {
+    int edge = k / tiles, t = k % tiles;
+    if (edge == 0) return vec2(t, 0);
+    if (edge == 1) return vec2(tiles, t);
+    if (edge == 2) return vec2(tiles - t, tiles);
+    return vec2(0, tiles - t);
+}
 
 void main() {
-    vec4 worldPos = model * vec4(aPos, 1.0);
-    gl_Position = projection * view * worldPos;
-    FragPos = worldPos.xyz;
-    Color = aColor;
-    Height = aPos.y;
+    chunkOrigin = aChunk.xy;
+    lodStep = int(aChunk.z);
+    int tiles = CHUNK_SIZE / lodStep;
+    int side = tiles + 1;
+    int vertex = gl_VertexID - aVertexBase;
+    bool skirt = vertex >= side * side;
+    vec2 grid = skirt ? skirtGrid(vertex - side * side, tiles)
+                      : vec2(vertex % side, vertex / side);
+    vec2 worldXZ = chunkOrigin + grid * float(lodStep) * TILE_SIZE;
+
+    // Chebyshev distance matches the ring that picked this chunk's LOD
+    vec2 offset = abs(worldXZ - lodFocus) / (float(CHUNK_SIZE) * TILE_SIZE);
+    float morph = clamp((max(offset.x, offset.y) - (aChunk.w - LOD_MORPH_WIDTH)) / LOD_MORPH_WIDTH, 0.0, 1.0);
+#ifdef GPU_TERRAIN
+    float height = terrainHeight(worldXZ);
+    if (morph > 0.0) height = mix(height, morphTarget(grid, height), morph);
+    if (skirt) height -= SKIRT_DEPTH * float(lodStep);
+#else
+    float height = mix(aHeight, aMorphHeight, morph);
+#endif
+
+    vec3 worldPos = vec3(worldXZ.x, height, worldXZ.y);
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+    FragPos = worldPos;
+    Color = terrainColor(height);
+    Height = height;
 }
 )";
 
@@ -444,9 +676,13 @@ in float Height;
 in vec3 FragPos;
 out vec4 FragColor;
 
-uniform vec3 cameraPos;
-uniform vec3 fogColor;
-uniform float fogDensity;
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPos;
+    float fogDensity;
+    vec3 fogColor;
+};
 
 void main() {
     vec3 color = Color;
@@ -466,21 +702,28 @@ void main() {
 }
 )";
 
+// Instanced: model matrix and color are per-instance attributes
 const char* carVertexShader = R"(
 #version 330 core
 layout (location = 0) in vec3 aPos;
+layout (location = 1) in mat4 aModel;
+layout (location = 5) in vec3 aColor;
 out vec3 Color;
 out vec3 FragPos;
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform vec3 carColor;
+
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPos;
+    float fogDensity;
+    vec3 fogColor;
+};
 
 void main() {
-    vec4 worldPos = model * vec4(aPos, 1.0);
+    vec4 worldPos = aModel * vec4(aPos, 1.0);
     gl_Position = projection * view * worldPos;
     FragPos = worldPos.xyz;
-    Color = carColor;
+    Color = aColor;
 }
 )";
 
@@ -489,9 +732,16 @@ const char* carFragmentShader = R"(
 in vec3 Color;
 in vec3 FragPos;
 out vec4 FragColor;
-uniform vec3 cameraPos;
-uniform vec3 fogColor;
-uniform float fogDensity;
+
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPos;
+    float fogDensity;
+    vec3 fogColor;
+};
+
+uniform float fogScale;     // 0 disables fog (puddles)
 
 void main() {
     vec3 color = Color;
@@ -500,7 +750,7 @@ void main() {
     color *= (0.5 + 0.5 * diff);
     
     float dist = length(cameraPos - FragPos);
-    float fogFactor = 1.0 - exp(-fogDensity * dist);
+    float fogFactor = 1.0 - exp(-fogDensity * fogScale * dist);
     color = mix(color, fogColor, fogFactor);
     
     FragColor = vec4(color, 1.0);
@@ -509,38 +759,105 @@ void main() {
 
 // ============ RENDERING FUNCTIONS ============
 
-void processInput(GLFWwindow* window);
+InputState processInput(GLFWwindow* window);
 void updateChunks();
-unsigned int createShaderProgram(const char* vs, const char* fs);
+unsigned int createShaderProgram(const char* vs, const char* fs,
+                                 const char* const* feedbackVaryings = nullptr, int feedbackCount = 0);
+
+// ---- Shader programs ----
+
+// Binding point of the FrameData uniform block shared by all programs
+const unsigned int FRAME_UBO_BINDING = 0;
+
+// std140 mirror of the FrameData block: vec3 + float pack into one vec4
+struct FrameUniforms {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec3 cameraPos;
+    float fogDensity;
+    glm::vec3 fogColor;
+    float pad;
+};
+
+// Linked program with every active uniform location resolved up front,
+// so the render loop never calls glGetUniformLocation
+struct ShaderProgram {
+    unsigned int id = 0;
+    std::map<std::string, GLint> uniforms;
+
+    bool create(const char* vs, const char* fs, const char* const* feedbackVaryings = nullptr, int feedbackCount = 0);
+    GLint uniform(const char* name) const;
+    void use() const { glUseProgram(id); }
+};
+
+// ---- Program binary cache ----
+// Linked programs are saved with glGetProgramBinary and restored with
+// glProgramBinary on the next launch, skipping GLSL compilation. Entries are
+// keyed by both sources plus the driver strings, so an edited shader or a
+// driver update simply misses; a binary the driver rejects is rebuilt from
+// source. Needs ARB_get_program_binary and at least one binary format.
+//
+// File, native-endian: "GT7P", uint32 version, uint32 count, then per entry
+//   uint64 key, uint32 format, uint32 length, length bytes
+
+const uint32_t PROGRAM_CACHE_VERSION = 1;
+
+struct ProgramBinaryCache {
+    struct Entry {
+        GLenum format;
+        std::vector<char> data;
+    };
 
-void processInput(GLFWwindow* window) {
+    bool enabled = false;
+    bool dirty = false;
+    std::string path;
+    std::unordered_map<uint64_t, Entry> entries;
+    int hits = 0, misses = 0;
+
+    void open(const std::string& cachePath);    // needs a current GL context
+    void save();
+    uint64_t key(const char* vs, const char* fs) const;
+    unsigned int load(uint64_t key);            // linked program, or 0
+    void store(uint64_t key, unsigned int program);
+};
+
+ProgramBinaryCache programCache;
+
+// Samples the keyboard; the simulation consumes the result on its own ticks
+InputState processInput(GLFWwindow* window) {
+    PROFILE_ZONE("processInput");
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
-    
-    if (glfwGetKey(window, GLFW_KEY_ENTER) == GLFW_PRESS && !gameStarted) {
-        gameStarted = true;
-        survivalTime = 0.0f;
-        policeCars.clear();
-        bullets.clear();
-        spawnPuddles();
-        spawnBuildings();
+
+    // Debug keys act on press, not while held
+    static bool f2Held = false, f3Held = false;
+    bool f2 = glfwGetKey(window, GLFW_KEY_F2) == GLFW_PRESS;
+    bool f3 = glfwGetKey(window, GLFW_KEY_F3) == GLFW_PRESS;
+    if (f2 && !f2Held) {
+        const char* tracePath = "gta7_trace.json";
+        if (profiler.writeChromeTrace(tracePath)) LOG_INFO("Trace written to %s", tracePath);
     }
+    if (f3 && !f3Held) showPerfOverlay = !showPerfOverlay;
+    f2Held = f2;
+    f3Held = f3;
     
-    if (!gameStarted) return;
-    
-    bool w = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
-    bool s = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
-    bool a = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
-    bool d = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
-    bool space = glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS;
+    InputState input;
+    input.start = glfwGetKey(window, GLFW_KEY_ENTER) == GLFW_PRESS;
+    input.forward = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
+    input.backward = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
+    input.left = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
+    input.right = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
+    input.drift = glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS;
     
-    car.update(deltaTime, w, s, a, d, space);
-    
-    if (w || s) targetVolume = 0.8f;
-    else targetVolume = 0.2f;
+    if (gameStarted) {
+        if (input.forward || input.backward) targetVolume = 0.8f;
+        else targetVolume = 0.2f;
+    }
+    return input;
 }
 
-unsigned int createShaderProgram(const char* vs, const char* fs) {
+// feedbackVaryings: interleaved transform-feedback outputs, set before linking
+unsigned int createShaderProgram(const char* vs, const char* fs, const char* const* feedbackVaryings, int feedbackCount) {
     unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
     glShaderSource(vertexShader, 1, &vs, NULL);
     glCompileShader(vertexShader);
@@ -557,110 +874,393 @@ unsigned int createShaderProgram(const char* vs, const char* fs) {
     glShaderSource(fragmentShader, 1, &fs, NULL);
     glCompileShader(fragmentShader);
 
+    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
+        std::cout << "Fragment shader compilation failed:\n" << infoLog << std::endl;
+    }
+
     unsigned int program = glCreateProgram();
     glAttachShader(program, vertexShader);
     glAttachShader(program, fragmentShader);
+    if (feedbackCount > 0) glTransformFeedbackVaryings(program, feedbackCount, feedbackVaryings, GL_INTERLEAVED_ATTRIBS);
+    if (programCache.enabled) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(program);
 
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
 
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        std::cout << "Shader program linking failed:\n" << infoLog << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+
     return program;
 }
 
-Chunk createChunk(int chunkX, int chunkZ) {
-    Chunk chunk;
-    chunk.x = chunkX;
-    chunk.z = chunkZ;
-
-    std::vector<float> vertices;
-    std::vector<unsigned int> indices;
+// Inserts "#define NAME" after the #version line of a shader source
+std::string withDefine(const char* source, const char* name) {
+    std::string s(source);
+    size_t lineEnd = s.find('\n', s.find("#version"));
+    return s.insert(lineEnd + 1, std::string("#define ") + name + "\n");
+}
 
-    for (int z = 0; z <= CHUNK_SIZE; z++) {
-        for (int x = 0; x <= CHUNK_SIZE; x++) {
-            float worldX = (chunkX * CHUNK_SIZE + x) * TILE_SIZE;
-            float worldZ = (chunkZ * CHUNK_SIZE + z) * TILE_SIZE;
-            float height = getTerrainHeight(worldX, worldZ);
-            
-            vertices.push_back(worldX);
-            vertices.push_back(height);
-            vertices.push_back(worldZ);
-            
-            if (height < 0.5f) {
-                vertices.push_back(0.3f); vertices.push_back(0.3f); vertices.push_back(0.3f);
-            } else if (height < 3.0f) {
-                vertices.push_back(0.35f); vertices.push_back(0.55f); vertices.push_back(0.25f);
-            } else {
-                vertices.push_back(0.45f); vertices.push_back(0.5f); vertices.push_back(0.45f);
-            }
+void ProgramBinaryCache::open(const std::string& cachePath) {
+    GLint formats = 0;
+    if (GLAD_GL_ARB_get_program_binary) glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats <= 0) return;
+    enabled = true;
+    path = cachePath;
+
+    std::ifstream file(path, std::ios::binary);
+    char magic[4];
+    uint32_t version = 0, count = 0;
+    if (!file.read(magic, 4) || memcmp(magic, "GT7P", 4) != 0 ||
+        !file.read((char*)&version, sizeof(version)) || version != PROGRAM_CACHE_VERSION ||
+        !file.read((char*)&count, sizeof(count))) {
+        return;     // missing or foreign: rebuilt and written after startup
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t k;
+        uint32_t format, length;
+        if (!file.read((char*)&k, sizeof(k)) || !file.read((char*)&format, sizeof(format)) ||
+            !file.read((char*)&length, sizeof(length))) {
+            break;
+        }
+        Entry& e = entries[k];
+        e.format = format;
+        e.data.resize(length);
+        if (!file.read(e.data.data(), length)) {
+            entries.erase(k);
+            break;
         }
     }
+}
+
+void ProgramBinaryCache::save() {
+    if (!enabled || !dirty) return;
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    uint32_t version = PROGRAM_CACHE_VERSION, count = (uint32_t)entries.size();
+    file.write("GT7P", 4);
+    file.write((const char*)&version, sizeof(version));
+    file.write((const char*)&count, sizeof(count));
+    for (const auto& pair : entries) {
+        uint32_t format = pair.second.format, length = (uint32_t)pair.second.data.size();
+        file.write((const char*)&pair.first, sizeof(pair.first));
+        file.write((const char*)&format, sizeof(format));
+        file.write((const char*)&length, sizeof(length));
+        file.write(pair.second.data.data(), length);
+    }
+    if (!file) std::cout << "Failed to write shader cache " << path << "\n";
+    dirty = false;
+}
+
+// FNV-1a over the sources and the driver identity
+uint64_t ProgramBinaryCache::key(const char* vs, const char* fs) const {
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&](const char* text) {
+        for (const char* p = text ? text : ""; *p; p++) h = (h ^ (unsigned char)*p) * 1099511628211ull;
+        h = (h ^ 0xff) * 1099511628211ull;      // separator
+    };
+    mix(vs);
+    mix(fs);
+    mix((const char*)glGetString(GL_VENDOR));
+    mix((const char*)glGetString(GL_RENDERER));
+    mix((const char*)glGetString(GL_VERSION));
+    return h;
+}
+
+unsigned int ProgramBinaryCache::load(uint64_t k) {
+    auto it = entries.find(k);
+    if (it == entries.end()) {
+        misses++;
+        return 0;
+    }
+    unsigned int program = glCreateProgram();
+    glProgramBinary(program, it->second.format, it->second.data.data(), (GLsizei)it->second.data.size());
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        glDeleteProgram(program);
+        entries.erase(it);
+        dirty = true;
+        misses++;
+        return 0;
+    }
+    hits++;
+    return program;
+}
+
+void ProgramBinaryCache::store(uint64_t k, unsigned int program) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+    Entry& e = entries[k];
+    e.data.resize(length);
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &e.format, e.data.data());
+    e.data.resize(written);
+    dirty = true;
+}
+
+// A cached binary keeps its feedback varyings, which are fixed per source
+bool ShaderProgram::create(const char* vs, const char* fs, const char* const* feedbackVaryings, int feedbackCount) {
+    uint64_t cacheKey = programCache.enabled ? programCache.key(vs, fs) : 0;
+    id = programCache.enabled ? programCache.load(cacheKey) : 0;
+    if (!id) {
+        id = createShaderProgram(vs, fs, feedbackVaryings, feedbackCount);
+        if (id && programCache.enabled) programCache.store(cacheKey, id);
+    }
+    uniforms.clear();
+    if (!id) return false;
+
+    GLint count = 0;
+    glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+    for (GLint i = 0; i < count; i++) {
+        char name[128];
+        GLsizei length = 0;
+        GLint size;
+        GLenum type;
+        glGetActiveUniform(id, i, sizeof(name), &length, &size, &type, name);
+        GLint location = glGetUniformLocation(id, name);
+        if (location < 0) continue;     // lives in a uniform block
+
+        std::string key(name, length);
+        if (key.size() > 3 && key.compare(key.size() - 3, 3, "[0]") == 0) key.resize(key.size() - 3);
+        uniforms[key] = location;
+    }
+
+    GLuint block = glGetUniformBlockIndex(id, "FrameData");
+    if (block != GL_INVALID_INDEX) glUniformBlockBinding(id, block, FRAME_UBO_BINDING);
+    return true;
+}
+
+GLint ShaderProgram::uniform(const char* name) const {
+    auto it = uniforms.find(name);
+    return it == uniforms.end() ? -1 : it->second;
+}
 
-    for (int z = 0; z < CHUNK_SIZE; z++) {
-        for (int x = 0; x < CHUNK_SIZE; x++) {
-            int topLeft = z * (CHUNK_SIZE + 1) + x;
-            int topRight = topLeft + 1;
-            int bottomLeft = (z + 1) * (CHUNK_SIZE + 1) + x;
-            int bottomRight = bottomLeft + 1;
+unsigned int createFrameUniformBuffer() {
+    unsigned int UBO;
+    glGenBuffers(1, &UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UBO_BINDING, UBO);
+    return UBO;
+}
 
-            indices.push_back(topLeft);
-            indices.push_back(bottomLeft);
-            indices.push_back(topRight);
+// Shared by every chunk VAO; built once at startup, one section per LOD
+unsigned int createTerrainIndexBuffer() {
+    std::vector<unsigned short> indices;
+
+    for (const TerrainLod& l : terrainLods) {
+        for (int z = 0; z < l.tiles; z++) {
+            for (int x = 0; x < l.tiles; x++) {
+                unsigned short topLeft = z * l.side + x;
+                unsigned short topRight = topLeft + 1;
+                unsigned short bottomLeft = (z + 1) * l.side + x;
+                unsigned short bottomRight = bottomLeft + 1;
+
+                indices.push_back(topLeft);
+                indices.push_back(bottomLeft);
+                indices.push_back(topRight);
+
+                indices.push_back(topRight);
+                indices.push_back(bottomLeft);
+                indices.push_back(bottomRight);
+            }
+        }
 
-            indices.push_back(topRight);
-            indices.push_back(bottomLeft);
-            indices.push_back(bottomRight);
+        // Skirt: a vertical strip from each border edge down to its skirt edge
+        int skirtCount = 4 * l.tiles;
+        for (int k = 0; k < skirtCount; k++) {
+            int x0, z0, x1, z1;
+            skirtGridPos(k, l.tiles, x0, z0);
+            skirtGridPos((k + 1) % skirtCount, l.tiles, x1, z1);
+            unsigned short top0 = z0 * l.side + x0;
+            unsigned short top1 = z1 * l.side + x1;
+            unsigned short bottom0 = l.side * l.side + k;
+            unsigned short bottom1 = l.side * l.side + (k + 1) % skirtCount;
+
+            indices.push_back(top0);
+            indices.push_back(bottom0);
+            indices.push_back(top1);
+
+            indices.push_back(top1);
+            indices.push_back(bottom0);
+            indices.push_back(bottom1);
         }
     }
 
-    chunk.indexCount = indices.size();
+    // Upload through GL_ARRAY_BUFFER: binding an element buffer here would
+    // overwrite whichever VAO happens to be bound
+    unsigned int EBO;
+    glGenBuffers(1, &EBO);
+    glBindBuffer(GL_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return EBO;
+}
+
+// Binds attributes 2 and 3 of the current VAO to the per-command ChunkDraw array
+void attachChunkDrawAttribute() {
+    if (!terrainMultiDraw) return;
+    glBindBuffer(GL_ARRAY_BUFFER, terrainDrawVBO);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(ChunkDraw), (void*)0);
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribIPointer(3, 1, GL_INT, sizeof(ChunkDraw), (void*)offsetof(ChunkDraw, vertexBase));
+    glVertexAttribDivisor(3, 1);
+    glEnableVertexAttribArray(3);
+}
+
+// ---- Chunk buffer pool ----
 
-    glGenVertexArrays(1, &chunk.VAO);
-    glGenBuffers(1, &chunk.VBO);
-    glGenBuffers(1, &chunk.EBO);
+void ChunkBufferPool::init(int slotCount) {
+    chunkSlots.init(slotCount, terrainLods[0].vertexCount);
+    if (headlessMode) return;   // no GL context: slot bookkeeping only
 
-    glBindVertexArray(chunk.VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, chunk.VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunk.EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, (size_t)slotCount * chunkSlots.slotVertices * 2 * sizeof(float), NULL, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, terrainIndexEBO);
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    glVertexAttribPointer(0, 1, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)sizeof(float));
     glEnableVertexAttribArray(1);
-
+    attachChunkDrawAttribute();
     glBindVertexArray(0);
-    return chunk;
+}
+
+void ChunkBufferPool::upload(int slot, const float* vertices, int vertexCount) {
+    if (headlessMode) return;
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, (size_t)chunkSlots.baseVertex(slot) * 2 * sizeof(float),
+                    (size_t)vertexCount * 2 * sizeof(float), vertices);
+}
+
+// GL thread only: copies a finished CPU mesh into a pool slot
+bool uploadChunkMesh(const ChunkMesh& mesh, Chunk& chunk) {
+    int slot = chunkSlots.acquire();
+    if (slot < 0) return false;
+    chunkPool.upload(slot, mesh.vertices, mesh.vertexCount);
+
+    chunk.x = mesh.x;
+    chunk.z = mesh.z;
+    chunk.lod = mesh.lod;
+    chunk.slot = slot;
+    chunk.heightfield = -1;
+    if (mesh.lod == 0) {
+        chunk.heightfield = heightfieldPool.acquire();
+        if (chunk.heightfield >= 0) {
+            Heightfield& field = heightfieldPool.entries[chunk.heightfield];
+            memcpy(field.heights, mesh.heights, sizeof(field.heights));
+            buildTileTypes(field, mesh.x, mesh.z);
+        }
+    }
+    chunk.minHeight = mesh.minHeight;
+    chunk.maxHeight = mesh.maxHeight;
+    return true;
 }
 
 void updateChunks() {
+    PROFILE_ZONE("updateChunks");
     int playerChunkX = (int)floor(car.position.x / (CHUNK_SIZE * TILE_SIZE));
     int playerChunkZ = (int)floor(car.position.z / (CHUNK_SIZE * TILE_SIZE));
 
+    // Evicts what left the keep window and cancels its requests; queued
+    // jobs out there are dropped by setFocus, in-flight meshes on arrival
+    chunks.recenter(playerChunkX, playerChunkZ);
+    chunkWorkers.setFocus(car.position, car.rotation, playerChunkX, playerChunkZ, CHUNK_KEEP_RADIUS);
+
+    if (gpuTerrainMode) {
+        // Nothing to build: a chunk is just an origin, a LOD and fixed bounds
+        for (int z = playerChunkZ - RENDER_DISTANCE; z <= playerChunkZ + RENDER_DISTANCE; z++) {
+            for (int x = playerChunkX - RENDER_DISTANCE; x <= playerChunkX + RENDER_DISTANCE; x++) {
+                int lod = chunkLodForRing(std::max(abs(x - playerChunkX), abs(z - playerChunkZ)));
+                ChunkTable::Cell* c = chunks.cell(x, z);
+                c->chunk = {x, z, lod, -1, -1, -SKIRT_DEPTH * terrainLods[lod].step, TERRAIN_MAX_HEIGHT};
+                c->resident = true;
+            }
+        }
+        return;
+    }
+
+    // Missing chunks, and loaded ones whose ring now wants another LOD. The
+    // old mesh keeps drawing until its replacement is uploaded.
     for (int z = playerChunkZ - RENDER_DISTANCE; z <= playerChunkZ + RENDER_DISTANCE; z++) {
         for (int x = playerChunkX - RENDER_DISTANCE; x <= playerChunkX + RENDER_DISTANCE; x++) {
-            std::pair<int, int> key = {x, z};
-            if (chunks.find(key) == chunks.end()) {
-                chunks[key] = createChunk(x, z);
+            ChunkTable::Cell* c = chunks.cell(x, z);
+            if (c->requested) continue;
+            bool stale = c->resident &&
+                c->chunk.lod != chunkLodForRing(std::max(abs(x - playerChunkX), abs(z - playerChunkZ)));
+            if (!c->resident || stale) {
+                c->requested = true;
+                chunkWorkers.request(x, z);
             }
         }
     }
 
-    std::vector<std::pair<int, int>> toRemove;
-    for (auto& pair : chunks) {
-        int dx = abs(pair.first.first - playerChunkX);
-        int dz = abs(pair.first.second - playerChunkZ);
-        if (dx > RENDER_DISTANCE + 2 || dz > RENDER_DISTANCE + 2) {
-            glDeleteVertexArrays(1, &pair.second.VAO);
-            glDeleteBuffers(1, &pair.second.VBO);
-            glDeleteBuffers(1, &pair.second.EBO);
-            toRemove.push_back(pair.first);
+    // Upload finished meshes nearest-first until the frame budget runs out
+    chunkWorkers.collectFinished(uploadQueue);
+    const ChunkMesh* records = chunkWorkers.records;
+    std::sort(uploadQueue.begin(), uploadQueue.end(), [&](int a, int b) {
+        int da = std::max(abs(records[a].x - playerChunkX), abs(records[a].z - playerChunkZ));
+        int db = std::max(abs(records[b].x - playerChunkX), abs(records[b].z - playerChunkZ));
+        return da < db;
+    });
+
+    auto uploadStart = std::chrono::steady_clock::now();
+    size_t uploaded = 0;
+    for (; uploaded < uploadQueue.size(); uploaded++) {
+        std::chrono::duration<double, std::milli> spent = std::chrono::steady_clock::now() - uploadStart;
+        if (uploaded > 0 && spent.count() > CHUNK_UPLOAD_BUDGET_MS) break;
+
+        const ChunkMesh& mesh = records[uploadQueue[uploaded]];
+        ChunkTable::Cell* c = chunks.cell(mesh.x, mesh.z);
+        if (!c || !c->requested) continue;
+
+        // A LOD change holds the old slot until the new mesh is in
+        Chunk chunk;
+        if (!uploadChunkMesh(mesh, chunk)) break;
+        if (c->resident) {
+            chunkSlots.release(c->chunk.slot);
+            heightfieldPool.release(c->chunk.heightfield);
         }
+        c->chunk = chunk;
+        c->resident = true;
+        c->requested = false;
     }
-    for (auto& key : toRemove) chunks.erase(key);
+    chunkWorkers.releaseRecords(uploadQueue.data(), uploaded);
+    uploadQueue.erase(uploadQueue.begin(), uploadQueue.begin() + uploaded);
 }
 
+// ---- Cube instancing ----
+// Every carVAO object (player, cops, buildings, puddles) is drawn
+// from one per-frame instance buffer, one glDrawElementsInstanced per batch.
+
+struct CubeInstance {
+    glm::mat4 model;
+    glm::vec3 color;
+};
+
+struct CubeBatch {
+    size_t first, count;
+};
+
+unsigned int cubeInstanceVBO = 0;
+std::vector<CubeInstance> cubeInstances;
+
+void bindCubeInstances(size_t first);
+
 unsigned int createCarVAO() {
     float carVerts[] = {
         -1, 0, -2,  1, 0, -2,  1, 1, -2,  -1, 1, -2,
@@ -688,269 +1288,1855 @@ unsigned int createCarVAO() {
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
-    
+
+    // Per-instance model matrix (locations 1-4) and color (5)
+    glGenBuffers(1, &cubeInstanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, cubeInstanceVBO);
+    for (int i = 1; i <= 5; i++) {
+        glEnableVertexAttribArray(i);
+        glVertexAttribDivisor(i, 1);
+    }
+    bindCubeInstances(0);
+
     return VAO;
 }
 
-void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    framebufferWidth = width;
-    framebufferHeight = height;
-    glViewport(0, 0, width, height);
+// Points the instance attributes of the bound carVAO at instance `first`.
+// Only needed without ARB_base_instance; with it the pointers stay at 0.
+void bindCubeInstances(size_t first) {
+    glBindBuffer(GL_ARRAY_BUFFER, cubeInstanceVBO);
+    size_t base = first * sizeof(CubeInstance);
+    for (int col = 0; col < 4; col++) {
+        glVertexAttribPointer(1 + col, 4, GL_FLOAT, GL_FALSE, sizeof(CubeInstance),
+                              (void*)(base + offsetof(CubeInstance, model) + col * sizeof(glm::vec4)));
+    }
+    glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, sizeof(CubeInstance),
+                          (void*)(base + offsetof(CubeInstance, color)));
 }
 
-int main() {
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-#ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-#endif
+void uploadCubeInstances(const std::vector<CubeInstance>& instances) {
+    glBindBuffer(GL_ARRAY_BUFFER, cubeInstanceVBO);
+    // Orphan last frame's storage so the driver never waits on it
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(CubeInstance), instances.data(), GL_STREAM_DRAW);
+}
 
-    GLFWwindow* window = glfwCreateWindow(1280, 720, "GTA7 - Police Chase", NULL, NULL);
-    if (!window) {
-        std::cout << "Failed to create window\n";
-        glfwTerminate();
-        return -1;
+void drawCubeBatch(const CubeBatch& batch) {
+    if (batch.count == 0) return;
+    if (GLAD_GL_ARB_base_instance) {
+        glDrawElementsInstancedBaseInstance(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0, (GLsizei)batch.count, (GLuint)batch.first);
+        return;
     }
-    glfwMakeContextCurrent(window);
+    bindCubeInstances(batch.first);
+    glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0, (GLsizei)batch.count);
+}
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cout << "Failed to initialize GLAD\n";
-        return -1;
-    }
+// ---- Static buildings ----
+// Buildings never move, so each spawnBuildings() layout is baked into
+// world-space geometry, one batch per chunk the buildings stand in, sharing
+// one VBO/EBO. The object shader's model matrix comes from a single
+// identity instance. Rebuilt on the GL thread when buildingGeneration changes.
 
-    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
-    glViewport(0, 0, framebufferWidth, framebufferHeight);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glEnable(GL_DEPTH_TEST);
+struct StaticVertex {
+    glm::vec3 position;
+    glm::vec3 color;
+};
 
-    if (ma_engine_init(NULL, &engine) != MA_SUCCESS) {
-        std::cout << "Failed to initialize audio\n";
-    } else {
-        if (ma_sound_init_from_file(&engine, "enginesound.mp3", MA_SOUND_FLAG_LOOPING, NULL, NULL, &engineSound) != MA_SUCCESS) {
-            std::cout << "Failed to load enginesound.mp3\n";
-        } else {
-            ma_sound_set_volume(&engineSound, 0.0f);
-            ma_sound_start(&engineSound);
-            isEngineLoaded = true;
-        }
-    }
+struct StaticBatch {
+    int chunkX, chunkZ;
+    glm::vec3 boundsMin, boundsMax;
+    GLsizei indexCount;
+    size_t firstIndex;
+    int buildingCount;
+};
 
-    unsigned int terrainShader = createShaderProgram(vertexShaderSource, fragmentShaderSource);
-    unsigned int carShader = createShaderProgram(carVertexShader, carFragmentShader);
-    unsigned int carVAO = createCarVAO();
-    
-    car.position.y = getTerrainHeight(0, 0) + 0.5f;
-    
-    std::cout << "\n=== GTA7 - POLICE CHASE ===\n";
-    std::cout << "Press ENTER to start\n";
-    std::cout << "W/S - Accelerate/Brake\n";
-    std::cout << "A/D - Steer\n";
-    std::cout << "SPACE - Drift (NFS style!)\n";
-    std::cout << "Avoid police cars and bullets!\n\n";
+struct StaticGeometry {
+    unsigned int VAO = 0, VBO = 0, EBO = 0, identityVBO = 0;
+    std::vector<StaticBatch> batches;
+    int builtForBuildings = -1;
 
-    float lastFrame = glfwGetTime();
+    void init();
+    void update();      // rebuilds if the buildings changed
+};
 
-    while (!glfwWindowShouldClose(window)) {
-        float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        deltaTime = fminf(deltaTime, 0.1f);
-        lastFrame = currentFrame;
-        processInput(window);
-        
-        if (isEngineLoaded) {
-            currentVolume += (targetVolume - currentVolume) * (1.0f - expf(-2.0f * deltaTime));
-            ma_sound_set_volume(&engineSound, currentVolume);
+void StaticGeometry::init() {
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+    glGenBuffers(1, &identityVBO);
+    glBindVertexArray(VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(StaticVertex), (void*)offsetof(StaticVertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, sizeof(StaticVertex), (void*)offsetof(StaticVertex, color));
+    glEnableVertexAttribArray(5);
+
+    // Instance 0 of a non-instanced draw: the identity model matrix
+    glm::mat4 identity(1.0f);
+    glBindBuffer(GL_ARRAY_BUFFER, identityVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(identity), &identity, GL_STATIC_DRAW);
+    for (int col = 0; col < 4; col++) {
+        glVertexAttribPointer(1 + col, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(col * sizeof(glm::vec4)));
+        glVertexAttribDivisor(1 + col, 1);
+        glEnableVertexAttribArray(1 + col);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBindVertexArray(0);
+}
+
+void StaticGeometry::update() {
+    if (builtForBuildings == buildingGeneration) return;
+    PROFILE_ZONE("staticGeometry.rebuild");
+    builtForBuildings = buildingGeneration;
+
+    // Same box the scaled car cube used to draw: [-1,1] x [0,1] x [-2,2]
+    static const glm::vec3 corners[8] = {
+        {-1, 0, -2}, {1, 0, -2}, {1, 1, -2}, {-1, 1, -2},
+        {-1, 0, 2}, {1, 0, 2}, {1, 1, 2}, {-1, 1, 2},
+    };
+    static const unsigned int faces[36] = {
+        0,1,2, 0,2,3,  4,5,6, 4,6,7,  0,4,7, 0,7,3,
+        1,5,6, 1,6,2,  3,2,6, 3,6,7,  0,1,5, 0,5,4,
+    };
+    const float chunkWorld = CHUNK_SIZE * TILE_SIZE;
+    const glm::vec3 color(0.4f, 0.4f, 0.4f);
+
+    std::vector<int> order(buildings.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = (int)i;
+    auto chunkOf = [&](int i) {
+        return std::make_pair((int)floor(buildings[i].position.x / chunkWorld), (int)floor(buildings[i].position.z / chunkWorld));
+    };
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return chunkOf(a) < chunkOf(b); });
+
+    std::vector<StaticVertex> vertices;
+    std::vector<unsigned int> indices;
+    batches.clear();
+    for (int i : order) {
+        const Building& b = buildings[i];
+        std::pair<int, int> chunk = chunkOf(i);
+        if (batches.empty() || batches.back().chunkX != chunk.first || batches.back().chunkZ != chunk.second) {
+            StaticBatch batch = {chunk.first, chunk.second, glm::vec3(1e30f), glm::vec3(-1e30f), 0, indices.size(), 0};
+            batches.push_back(batch);
         }
-        
-        if (gameStarted) {
-            survivalTime += deltaTime;
-            if (survivalTime > highScore) highScore = survivalTime;
-            
-            spawnTimer += deltaTime;
-            if (spawnTimer > 8.0f && policeCars.size() < 5) {
-                spawnPoliceCar();
-                spawnTimer = 0;
-            }
-            
-            for (auto& cop : policeCars) {
-                cop.update(deltaTime, car.position);
-                
-                float dist = glm::length(cop.position - car.position);
-                if (dist < 3.0f) {
-                    survivalTime -= 5.0f;
-                    if (survivalTime < 0) survivalTime = 0;
-                    cop.position = car.position + glm::vec3(50, 0, 50);
-                    std::cout << "HIT BY POLICE! -5 seconds\n";
+        StaticBatch& batch = batches.back();
+        unsigned int base = (unsigned int)vertices.size();
+        glm::vec3 scale(b.width, b.height, b.depth);
+        for (const glm::vec3& c : corners) {
+            glm::vec3 p = b.position + c * scale;
+            vertices.push_back({p, color});
+            batch.boundsMin = glm::min(batch.boundsMin, p);
+            batch.boundsMax = glm::max(batch.boundsMax, p);
+        }
+        for (unsigned int f : faces) indices.push_back(base + f);
+        batch.indexCount += 36;
+        batch.buildingCount++;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(StaticVertex), vertices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(VAO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+    framebufferWidth = width;
+    framebufferHeight = height;
+    glViewport(0, 0, width, height);
+}
+
+// ============ TEXT OVERLAY ============
+// Screen-space text from a glyph atlas baked once with stb_truetype, with
+// the HUD and overlay sizes packed side by side. All quads for a frame (HUD
+// and perf overlay alike) go into one dynamic vertex buffer and one draw call.
+
+const char* textVertexShader = R"(
+#version 330 core
+layout (location = 0) in vec2 aPos;     // pixels, origin top-left
+layout (location = 1) in vec2 aUV;
+layout (location = 2) in vec4 aColor;
+out vec2 UV;
+out vec4 Color;
+uniform vec2 screenSize;
+
+void main() {
+    gl_Position = vec4(aPos.x / screenSize.x * 2.0 - 1.0, 1.0 - aPos.y / screenSize.y * 2.0, 0.0, 1.0);
+    UV = aUV;
+    Color = aColor;
+}
+)";
+
+const char* textFragmentShader = R"(
+#version 330 core
+in vec2 UV;
+in vec4 Color;
+out vec4 FragColor;
+uniform sampler2D atlas;
+
+void main() {
+    FragColor = vec4(Color.rgb, Color.a * texture(atlas, UV).r);
+}
+)";
+
+// Monospace first; any TTF/TTC works
+const char* overlayFontPaths[] = {
+    "C:/Windows/Fonts/consola.ttf",
+    "C:/Windows/Fonts/arial.ttf",
+    "/System/Library/Fonts/Menlo.ttc",
+    "/System/Library/Fonts/Monaco.ttf",
+    "/System/Library/Fonts/Supplemental/Arial.ttf",
+    "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf",
+    "/usr/share/fonts/TTF/DejaVuSansMono.ttf",
+    "/usr/share/fonts/dejavu/DejaVuSansMono.ttf",
+    "/usr/share/fonts/truetype/liberation/LiberationMono-Regular.ttf",
+};
+
+enum TextSize {
+    TEXT_SMALL,     // perf overlay
+    TEXT_LARGE,     // HUD
+    TEXT_SIZE_COUNT
+};
+
+struct TextRenderer {
+    static const int ATLAS_SIZE = 512;
+    static const int FIRST_CHAR = 32;
+    static const int CHAR_COUNT = 95;           // printable ASCII
+    static constexpr float PIXEL_HEIGHT = 18.0f;
+    static constexpr float HUD_PIXEL_HEIGHT = 32.0f;
+
+    bool ready = false;
+    ShaderProgram shader;
+    GLint screenSizeLoc = -1;
+    unsigned int texture = 0, VAO = 0, VBO = 0;
+    size_t bufferBytes = 0;
+    stbtt_packedchar glyphs[TEXT_SIZE_COUNT][CHAR_COUNT];
+    glm::vec2 whiteUV;                          // solid texel for panels
+    std::vector<float> verts;                   // x, y, u, v, r, g, b, a
+
+    static float pixelHeight(TextSize size) { return size == TEXT_LARGE ? HUD_PIXEL_HEIGHT : PIXEL_HEIGHT; }
+
+    bool init();
+    void addQuad(float x0, float y0, float x1, float y1, float u0, float v0, float u1, float v1, const glm::vec4& color);
+    void addRect(float x0, float y0, float x1, float y1, const glm::vec4& color);
+    float addText(float x, float y, const char* text, const glm::vec4& color, TextSize size = TEXT_SMALL);  // returns end x
+    float textWidth(const char* text, TextSize size = TEXT_SMALL) const;
+    void flush(int width, int height);
+};
+
+TextRenderer textRenderer;
+
+bool TextRenderer::init() {
+    std::vector<unsigned char> font;
+    for (const char* path : overlayFontPaths) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) continue;
+        font.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        if (!font.empty()) break;
+    }
+    if (font.empty()) {
+        std::cout << "No system font found, text overlay disabled\n";
+        return false;
+    }
+
+    // Both sizes share one atlas; the last row is left out of the packing
+    // so its bottom-right texel can stay opaque for solid rectangles
+    std::vector<unsigned char> bitmap(ATLAS_SIZE * ATLAS_SIZE, 0);
+    int offset = stbtt_GetFontOffsetForIndex(font.data(), 0);
+    stbtt_pack_context pack;
+    bool packed = offset >= 0 && stbtt_PackBegin(&pack, bitmap.data(), ATLAS_SIZE, ATLAS_SIZE - 1, ATLAS_SIZE, 1, NULL);
+    if (packed) {
+        for (int size = 0; size < TEXT_SIZE_COUNT && packed; size++) {
+            packed = stbtt_PackFontRange(&pack, font.data(), 0, pixelHeight((TextSize)size),
+                                         FIRST_CHAR, CHAR_COUNT, glyphs[size]) != 0;
+        }
+        stbtt_PackEnd(&pack);
+    }
+    if (!packed) {
+        std::cout << "Failed to bake overlay font\n";
+        return false;
+    }
+    bitmap[ATLAS_SIZE * ATLAS_SIZE - 1] = 255;
+    whiteUV = glm::vec2((ATLAS_SIZE - 0.5f) / ATLAS_SIZE);
+
+    if (!shader.create(textVertexShader, textFragmentShader)) return false;
+    screenSizeLoc = shader.uniform("screenSize");
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, ATLAS_SIZE, ATLAS_SIZE, 0, GL_RED, GL_UNSIGNED_BYTE, bitmap.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(4 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glBindVertexArray(0);
+
+    ready = true;
+    return true;
+}
+
+void TextRenderer::addQuad(float x0, float y0, float x1, float y1, float u0, float v0, float u1, float v1, const glm::vec4& c) {
+    const float quad[6][4] = {
+        {x0, y0, u0, v0}, {x1, y0, u1, v0}, {x1, y1, u1, v1},
+        {x0, y0, u0, v0}, {x1, y1, u1, v1}, {x0, y1, u0, v1},
+    };
+    for (const auto& v : quad) {
+        verts.insert(verts.end(), {v[0], v[1], v[2], v[3], c.r, c.g, c.b, c.a});
+    }
+}
+
+void TextRenderer::addRect(float x0, float y0, float x1, float y1, const glm::vec4& color) {
+    addQuad(x0, y0, x1, y1, whiteUV.x, whiteUV.y, whiteUV.x, whiteUV.y, color);
+}
+
+float TextRenderer::addText(float x, float y, const char* text, const glm::vec4& color, TextSize size) {
+    if (!ready) return x;
+    float baseline = y + pixelHeight(size) * 0.8f;
+    for (const char* c = text; *c; c++) {
+        int index = (unsigned char)*c - FIRST_CHAR;
+        if (index < 0 || index >= CHAR_COUNT) continue;
+        stbtt_aligned_quad q;
+        stbtt_GetPackedQuad(glyphs[size], ATLAS_SIZE, ATLAS_SIZE, index, &x, &baseline, &q, 1);
+        addQuad(q.x0, q.y0, q.x1, q.y1, q.s0, q.t0, q.s1, q.t1, color);
+    }
+    return x;
+}
+
+float TextRenderer::textWidth(const char* text, TextSize size) const {
+    float width = 0.0f;
+    for (const char* c = text; *c; c++) {
+        int index = (unsigned char)*c - FIRST_CHAR;
+        if (index >= 0 && index < CHAR_COUNT) width += glyphs[size][index].xadvance;
+    }
+    return width;
+}
+
+void TextRenderer::flush(int width, int height) {
+    if (!ready || verts.empty()) {
+        verts.clear();
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    size_t bytes = verts.size() * sizeof(float);
+    if (bytes > bufferBytes) {
+        bufferBytes = bytes * 2;
+        glBufferData(GL_ARRAY_BUFFER, bufferBytes, NULL, GL_STREAM_DRAW);
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, verts.data());
+
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    shader.use();
+    glUniform2f(screenSizeLoc, (float)width, (float)height);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glBindVertexArray(VAO);
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(verts.size() / 8));
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+
+    verts.clear();
+}
+
+// ============ STARTUP ============
+// Phase durations and milestones since launch, in ms, for the bench report.
+// The window is presented before the renderer is built; the world then
+// streams in nearest chunks first, so the milestones that matter are the
+// first rendered frame and the player's own ring of chunks being resident.
+
+struct StartupTimings {
+    double launch = 0;                          // nowMs() on entry to main
+    double window = 0, renderer = 0, shaders = 0, world = 0;
+    double firstFrame = -1, nearChunks = -1;    // since launch, -1 until reached
+
+    // Called once per frame until both milestones are recorded
+    void noteFrame() {
+        if (firstFrame >= 0 && nearChunks >= 0) return;
+        double now = nowMs() - launch;
+        if (firstFrame < 0) firstFrame = now;
+        if (nearChunks < 0) {
+            int cx = (int)floor(car.position.x / (CHUNK_SIZE * TILE_SIZE));
+            int cz = (int)floor(car.position.z / (CHUNK_SIZE * TILE_SIZE));
+            for (int dz = -1; dz <= 1; dz++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    ChunkTable::Cell* cell = chunks.cell(cx + dx, cz + dz);
+                    if (!cell || !cell->resident) return;
                 }
             }
-            
-            shootTimer += deltaTime;
-            if (shootTimer > 2.0f && !policeCars.empty()) {
-                auto& cop = policeCars[0];
-                glm::vec3 dir = glm::normalize(car.position - cop.position);
-                Bullet b;
-                b.pos = cop.position + glm::vec3(0, 1, 0);
-                b.vel = dir * 30.0f;
-                b.lifetime = 3.0f;
-                bullets.push_back(b);
-                shootTimer = 0;
-            }
-            
-            for (auto& b : bullets) {
-                b.pos += b.vel * deltaTime;
-                b.lifetime -= deltaTime;
-                
-                float dist = glm::length(b.pos - car.position);
-                if (dist < 2.0f) {
-                    survivalTime -= 1.0f;
-                    if (survivalTime < 0) survivalTime = 0;
-                    b.lifetime = 0;
-                    std::cout << "SHOT! -1 second\n";
-                }
+            nearChunks = now;
+        }
+    }
+};
+
+StartupTimings startup;
+
+// ============ PARTICLES ============
+// Drift smoke, puddle splashes, muzzle flashes, hit sparks and bullet
+// tracers are visual only and live entirely on the GPU: two ping-pong
+// buffers of fixed slots, advanced each frame by a transform-feedback pass
+// and drawn as instanced camera-facing quads. The CPU only writes newly
+// spawned particles into a ring of slots, so effects cost nothing in the sim
+// tick. Bullets and their hit tests stay in the sim's SoA pool; every
+// TRACER_INTERVAL a short-lived tracer particle is dropped per bullet, and
+// the copies fade into a trail.
+//
+// Tracers have their own slot range after the effects ring, sized for every
+// emission that can be alive at once, so they never overwrite smoke or
+// sparks mid-life. Only the first PARTICLE_TRACERS_PER_EMIT bullets in pool
+// order get tracers; the rest are simulated but undrawn.
+
+const int PARTICLE_EFFECT_CAPACITY = 16384;     // smoke, splashes, muzzle flashes and sparks
+const float TRACER_LIFETIME = 0.08f;
+const float TRACER_INTERVAL = 1.0f / 75.0f;     // at least this long between emissions, at most one per frame
+const int TRACER_GENERATIONS = 7;               // emissions alive at once: floor(lifetime / interval) + 1
+const int PARTICLE_TRACERS_PER_EMIT = 2048;
+const int PARTICLE_TRACER_CAPACITY = TRACER_GENERATIONS * PARTICLE_TRACERS_PER_EMIT;
+const int PARTICLE_CAPACITY = PARTICLE_EFFECT_CAPACITY + PARTICLE_TRACER_CAPACITY;
+
+// Layout shared with the update shader's interleaved feedback varyings
+struct GpuParticle {
+    glm::vec3 position;
+    float life;             // seconds left; <= 0 is a free slot
+    glm::vec3 velocity;
+    float size;             // billboard half-size
+    glm::vec4 color;
+    float lifetime;         // at spawn, for the fade
+    float growth;           // size per second
+    float drag;             // velocity lost per second, as a fraction
+    float gravity;          // negative rises
+};
+static_assert(sizeof(GpuParticle) == 16 * sizeof(float), "GpuParticle must match the shader varyings");
+
+const char* particleUpdateShader = R"(
+#version 330 core
+layout (location = 0) in vec4 aPosLife;
+layout (location = 1) in vec4 aVelSize;
+layout (location = 2) in vec4 aColor;
+layout (location = 3) in vec4 aParams;  // lifetime, growth, drag, gravity
+out vec4 PosLife;
+out vec4 VelSize;
+out vec4 Color;
+out vec4 Params;
+uniform float dt;
+
+void main() {
+    vec3 v = aVelSize.xyz;
+    if (aPosLife.w > 0.0) {
+        v *= max(1.0 - aParams.z * dt, 0.0);
+        v.y -= aParams.w * dt;
+    }
+    PosLife = vec4(aPosLife.xyz + v * dt, aPosLife.w - dt);
+    VelSize = vec4(v, aVelSize.w + aParams.y * dt);
+    Color = aColor;
+    Params = aParams;
+}
+)";
+
+const char* particleNullFragmentShader = R"(
+#version 330 core
+void main() {}
+)";
+
+const char* particleVertexShader = R"(
+#version 330 core
+layout (location = 0) in vec2 aCorner;  // [-1, 1] quad
+layout (location = 1) in vec4 aPosLife;
+layout (location = 2) in vec4 aVelSize;
+layout (location = 3) in vec4 aColor;
+layout (location = 4) in vec4 aParams;
+out vec2 Corner;
+out vec4 Color;
+out vec3 FragPos;
+
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPos;
+    float fogDensity;
+    vec3 fogColor;
+};
+
+void main() {
+    Corner = aCorner;
+    if (aPosLife.w <= 0.0) {
+        // Free slot: outside the clip volume
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        Color = vec4(0.0);
+        FragPos = vec3(0.0);
+        return;
+    }
+    vec3 right = vec3(view[0][0], view[1][0], view[2][0]);
+    vec3 up = vec3(view[0][1], view[1][1], view[2][1]);
+    FragPos = aPosLife.xyz + (right * aCorner.x + up * aCorner.y) * aVelSize.w;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+    Color = vec4(aColor.rgb, aColor.a * clamp(aPosLife.w / aParams.x, 0.0, 1.0));
+}
+)";
+
+const char* particleFragmentShader = R"(
+#version 330 core
+in vec2 Corner;
+in vec4 Color;
+in vec3 FragPos;
+out vec4 FragColor;
+
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPos;
+    float fogDensity;
+    vec3 fogColor;
+};
+
+void main() {
+    float r = dot(Corner, Corner);
+    if (r > 1.0) discard;
+    float fogFactor = 1.0 - exp(-fogDensity * length(cameraPos - FragPos));
+    FragColor = vec4(mix(Color.rgb, fogColor, fogFactor), Color.a * (1.0 - r));
+}
+)";
+
+struct ParticleSystem {
+    ShaderProgram updateShader, drawShader;
+    GLint dtLoc = -1;
+    unsigned int buffers[2] = {0, 0};
+    unsigned int updateVAO[2] = {0, 0};     // reads buffers[i] as points
+    unsigned int drawVAO[2] = {0, 0};       // quad corners + buffers[i] per instance
+    unsigned int quadVBO = 0;
+    int current = 0;                        // buffer holding the latest state
+    int cursor = 0;                         // next effect slot a spawn overwrites
+    int tracerCursor = 0;                   // next slot in the tracer range
+    float sinceTracers = TRACER_INTERVAL;   // time since the last tracer emission
+    float aliveFor = 0.0f;                  // until every particle has expired
+    float smokeOwed = 0.0f, splashOwed = 0.0f;  // fractional particles carried between frames
+    uint32_t rng = 0x1234567u;              // own LCG: the game RNG must stay replayable
+    std::vector<GpuParticle> staged;        // spawned this frame
+    std::vector<GpuParticle> stagedTracers;
+    bool ready = false;
+
+    bool init();
+    void update(float dt, float alpha);     // emitters, uploads, then the feedback pass
+    void draw();
+
+    float random() {
+        rng = rng * 1664525u + 1013904223u;
+        return (rng >> 8) * (1.0f / 16777216.0f);
+    }
+    float random(float lo, float hi) { return lo + (hi - lo) * random(); }
+    void spawn(ParticleEffect effect, const glm::vec3& position, const glm::vec3& direction, int count);
+    void upload(std::vector<GpuParticle>& from, int first, int slots, int& slotCursor);
+};
+
+ParticleSystem particles;
+
+// Points locations first.. first+3 at the particle fields of the bound buffer
+static void attachParticleAttributes(int first, int divisor) {
+    for (int i = 0; i < 4; i++) {
+        glVertexAttribPointer(first + i, 4, GL_FLOAT, GL_FALSE, sizeof(GpuParticle), (void*)(i * 4 * sizeof(float)));
+        glVertexAttribDivisor(first + i, divisor);
+        glEnableVertexAttribArray(first + i);
+    }
+}
+
+bool ParticleSystem::init() {
+    static const char* varyings[] = {"PosLife", "VelSize", "Color", "Params"};
+    if (!updateShader.create(particleUpdateShader, particleNullFragmentShader, varyings, 4) ||
+        !drawShader.create(particleVertexShader, particleFragmentShader)) {
+        std::cout << "Particles disabled\n";
+        return false;
+    }
+    dtLoc = updateShader.uniform("dt");
+
+    const float corners[] = {-1, -1, 1, -1, -1, 1, 1, 1};
+    glGenBuffers(1, &quadVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+
+    std::vector<GpuParticle> empty(PARTICLE_CAPACITY, GpuParticle{});
+    glGenBuffers(2, buffers);
+    glGenVertexArrays(2, updateVAO);
+    glGenVertexArrays(2, drawVAO);
+    for (int i = 0; i < 2; i++) {
+        glBindBuffer(GL_ARRAY_BUFFER, buffers[i]);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(GpuParticle) * PARTICLE_CAPACITY, empty.data(), GL_DYNAMIC_COPY);
+
+        glBindVertexArray(updateVAO[i]);
+        attachParticleAttributes(0, 0);
+
+        glBindVertexArray(drawVAO[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, buffers[i]);
+        attachParticleAttributes(1, 1);
+    }
+    glBindVertexArray(0);
+    staged.reserve(PARTICLE_EFFECT_CAPACITY);
+    stagedTracers.reserve(PARTICLE_TRACERS_PER_EMIT);
+    ready = true;
+    return true;
+}
+
+void ParticleSystem::spawn(ParticleEffect effect, const glm::vec3& position, const glm::vec3& direction, int count) {
+    std::vector<GpuParticle>& out = effect == EFFECT_TRACER ? stagedTracers : staged;
+    int room = effect == EFFECT_TRACER ? PARTICLE_TRACERS_PER_EMIT : PARTICLE_EFFECT_CAPACITY;
+    count = std::min(count, room - (int)out.size());
+    for (int i = 0; i < count; i++) {
+        GpuParticle p = {};
+        glm::vec3 jitter(random(-1, 1), random(-1, 1), random(-1, 1));
+        switch (effect) {
+            case EFFECT_SMOKE:
+                p.position = position + jitter * 0.4f;
+                p.velocity = direction * 1.5f + glm::vec3(jitter.x, random(0.8f, 1.6f), jitter.z);
+                p.color = glm::vec4(0.6f, 0.6f, 0.62f, 0.45f);
+                p.size = 0.35f;
+                p.lifetime = random(1.2f, 1.8f);
+                p.growth = 1.1f;
+                p.drag = 1.5f;
+                p.gravity = -0.3f;
+                break;
+            case EFFECT_SPLASH:
+                p.position = position + glm::vec3(jitter.x, 0.0f, jitter.z) * 0.8f;
+                p.velocity = glm::vec3(jitter.x * 2.0f, random(3.0f, 5.5f), jitter.z * 2.0f) + direction;
+                p.color = glm::vec4(0.55f, 0.7f, 1.0f, 0.8f);
+                p.size = 0.12f;
+                p.lifetime = random(0.5f, 0.8f);
+                p.drag = 0.3f;
+                p.gravity = 9.8f;
+                break;
+            case EFFECT_MUZZLE:
+                p.position = position;
+                p.velocity = direction * random(8.0f, 14.0f) + jitter * 1.5f;
+                p.color = glm::vec4(1.0f, 0.8f, 0.3f, 1.0f);
+                p.size = 0.25f;
+                p.lifetime = random(0.08f, 0.15f);
+                p.growth = -1.0f;
+                p.drag = 4.0f;
+                break;
+            case EFFECT_SPARKS:
+                p.position = position + glm::vec3(0.0f, 0.8f, 0.0f);
+                p.velocity = glm::vec3(jitter.x, std::fabs(jitter.y) + 0.3f, jitter.z) * 6.0f;
+                p.color = glm::vec4(1.0f, 0.55f, 0.15f, 1.0f);
+                p.size = 0.1f;
+                p.lifetime = random(0.3f, 0.6f);
+                p.drag = 1.0f;
+                p.gravity = 9.8f;
+                break;
+            case EFFECT_TRACER:
+                // Stays where the bullet was; the frames' copies fade into a streak
+                p.position = position;
+                p.color = glm::vec4(1.0f, 0.25f, 0.1f, 1.0f);
+                p.size = 0.15f;
+                p.lifetime = TRACER_LIFETIME;
+                p.growth = -1.0f;
+                break;
+            default:
+                break;
+        }
+        p.life = p.lifetime;
+        aliveFor = std::max(aliveFor, p.lifetime);
+        out.push_back(p);
+    }
+}
+
+void ParticleSystem::update(float dt, float alpha) {
+    if (!ready) return;
+    PROFILE_ZONE("render.particles");
+
+    // Advance what is already alive first, so this frame's spawns are drawn
+    // once at full life however long the frame took
+    if (aliveFor > 0.0f) {
+        aliveFor -= dt;
+        updateShader.use();
+        glUniform1f(dtLoc, dt);
+        glEnable(GL_RASTERIZER_DISCARD);
+        glBindVertexArray(updateVAO[current]);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffers[1 - current]);
+        glBeginTransformFeedback(GL_POINTS);
+        glDrawArrays(GL_POINTS, 0, PARTICLE_CAPACITY);
+        glEndTransformFeedback();
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+        glDisable(GL_RASTERIZER_DISCARD);
+        current = 1 - current;
+    }
+
+    // Continuous emitters follow the car
+    if (gameStarted) {
+        glm::vec3 forward(sin(car.rotation), 0.0f, cos(car.rotation));
+        bool inPuddle = getTerrainInfo(car.position.x, car.position.z).type == TERRAIN_PUDDLE;
+        float speed = std::fabs(car.speed);
+        if (inPuddle && speed > 1.0f) {
+            splashOwed += (30.0f + 6.0f * speed) * dt;
+            int n = (int)splashOwed;
+            splashOwed -= n;
+            spawn(EFFECT_SPLASH, car.position - glm::vec3(0, 0.5f, 0), forward * (0.2f * speed), n);
+        } else if (car.isDrifting && speed > 2.0f) {
+            smokeOwed += 90.0f * dt;
+            int n = (int)smokeOwed;
+            smokeOwed -= n;
+            spawn(EFFECT_SMOKE, car.position - forward * 2.0f - glm::vec3(0, 0.3f, 0), -forward, n);
+        }
+    }
+    sinceTracers += dt;
+    if (sinceTracers >= TRACER_INTERVAL) {
+        sinceTracers = 0.0f;
+        size_t tracers = std::min(bullets.size(), (size_t)PARTICLE_TRACERS_PER_EMIT);
+        for (size_t i = 0; i < tracers; i++)
+            spawn(EFFECT_TRACER, glm::mix(bullets.vec3(BULLET_PREV_X, i), bullets.vec3(BULLET_X, i), alpha), glm::vec3(0.0f), 1);
+    }
+    const int burstSize[EFFECT_COUNT] = {0, 0, 12, 24, 0};
+    for (int i = 0; i < particleBurstCount; i++) {
+        const ParticleBurst& b = particleBursts[i];
+        spawn(b.effect, b.position, b.direction, burstSize[b.effect]);
+    }
+    particleBurstCount = 0;
+    frameStats.particlesSpawned = (int)(staged.size() + stagedTracers.size());
+
+    upload(staged, 0, PARTICLE_EFFECT_CAPACITY, cursor);
+    upload(stagedTracers, PARTICLE_EFFECT_CAPACITY, PARTICLE_TRACER_CAPACITY, tracerCursor);
+}
+
+// New particles overwrite the oldest slots of their range in the current buffer
+void ParticleSystem::upload(std::vector<GpuParticle>& from, int first, int slots, int& slotCursor) {
+    if (from.empty()) return;
+    int n = (int)from.size();
+    int tail = std::min(n, slots - slotCursor);
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[current]);
+    glBufferSubData(GL_ARRAY_BUFFER, (first + slotCursor) * sizeof(GpuParticle), tail * sizeof(GpuParticle), from.data());
+    if (n > tail) glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(GpuParticle), (n - tail) * sizeof(GpuParticle), from.data() + tail);
+    slotCursor = (slotCursor + n) % slots;
+    from.clear();
+}
+
+// Translucent but unsorted: soft, short-lived puffs blend acceptably in any order
+void ParticleSystem::draw() {
+    if (!ready || aliveFor <= 0.0f) return;
+    drawShader.use();
+    glBindVertexArray(drawVAO[current]);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, PARTICLE_CAPACITY);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+    frameStats.objectDrawCalls++;
+}
+
+// ============ RENDER QUEUE ============
+// Object draws are submitted as DrawItems and issued in one pass, sorted by
+// a packed 64-bit key so program, VAO, blend and uniform changes happen only
+// between runs of items that need them. Key, high bit first:
+//   opaque:      0 | program:12 | vao:12 | fog:1 | depth:16, front to back
+//   translucent: 1 | depth:24, back to front | program:12 | vao:12 | fog:1
+// Terrain keeps its own (multi-draw) pass ahead of the queue.
+
+enum BlendMode {
+    BLEND_OPAQUE,
+    BLEND_ALPHA,
+};
+
+struct DrawItem {
+    uint64_t key;
+    unsigned int program, vao;
+    BlendMode blend;
+    GLint fogLoc;               // the program's fogScale
+    float fog;
+    GLsizei indexCount;         // GL_UNSIGNED_INT indices
+    size_t firstIndex;
+    GLsizei instanceCount;      // > 0: instances from cubeInstanceVBO, starting at firstInstance
+    size_t firstInstance;
+};
+
+const float DRAW_DEPTH_RANGE = 2000.0f;     // the far plane
+
+uint64_t drawKey(const DrawItem& item, float depth) {
+    float t = std::min(std::max(depth / DRAW_DEPTH_RANGE, 0.0f), 1.0f);
+    uint64_t program = item.program & 0xFFF, vao = item.vao & 0xFFF, fog = item.fog > 0.0f ? 1 : 0;
+    if (item.blend == BLEND_OPAQUE) {
+        uint64_t d = (uint64_t)(t * 0xFFFF);
+        return (program << 51) | (vao << 39) | (fog << 38) | (d << 22);
+    }
+    uint64_t d = 0xFFFFFF - (uint64_t)(t * 0xFFFFFF);
+    return (1ull << 63) | (d << 39) | (program << 27) | (vao << 15) | (fog << 14);
+}
+
+struct RenderQueue {
+    std::vector<DrawItem> items;
+
+    void submit(DrawItem item, float depth) {
+        item.key = drawKey(item, depth);
+        items.push_back(item);
+    }
+    void flush();
+};
+
+void RenderQueue::flush() {
+    // Equal keys share every piece of state, so their order is free
+    std::sort(items.begin(), items.end(), [](const DrawItem& a, const DrawItem& b) { return a.key < b.key; });
+
+    unsigned int program = 0, vao = 0;
+    BlendMode blend = BLEND_OPAQUE;
+    float fog = -1.0f;
+    for (const DrawItem& item : items) {
+        if (item.program != program) {
+            glUseProgram(item.program);
+            program = item.program;
+            fog = -1.0f;
+            frameStats.programChanges++;
+        }
+        if (item.vao != vao) {
+            glBindVertexArray(item.vao);
+            vao = item.vao;
+            frameStats.vaoChanges++;
+        }
+        if (item.blend != blend) {
+            if (item.blend == BLEND_ALPHA) {
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            } else {
+                glDisable(GL_BLEND);
             }
-            bullets.erase(std::remove_if(bullets.begin(), bullets.end(),
-                [](const Bullet& b) { return b.lifetime <= 0; }), bullets.end());
+            blend = item.blend;
+            frameStats.blendChanges++;
         }
-        
-        updateChunks();
+        if (item.fog != fog) {
+            glUniform1f(item.fogLoc, item.fog);
+            fog = item.fog;
+        }
+        if (item.instanceCount > 0) {
+            drawCubeBatch({item.firstInstance, (size_t)item.instanceCount});
+        } else {
+            glDrawElements(GL_TRIANGLES, item.indexCount, GL_UNSIGNED_INT, (void*)(item.firstIndex * sizeof(unsigned int)));
+        }
+        frameStats.objectDrawCalls++;
+    }
+    if (blend != BLEND_OPAQUE) glDisable(GL_BLEND);
+    items.clear();
+}
+
+// ============ FRAME RENDERING ============
+
+struct Renderer {
+    ShaderProgram terrainShader, carShader;
+    GLint lodFocusLoc = -1;
+    GLint fogScaleLoc = -1;
+    unsigned int frameUBO = 0;
+    unsigned int carVAO = 0;
+    unsigned int proceduralTerrainVAO = 0;  // index buffer only, for gpuTerrainMode
+    unsigned int terrainIndirectBuffer = 0;
+    std::vector<DrawElementsIndirectCommand> terrainCommands;
+    std::vector<ChunkDraw> terrainDraws;
+    RenderQueue queue;
+    StaticGeometry staticBuildings;
+    GpuTimer gpuTerrain, gpuObjects, gpuOverlay;
+    bool terrainVertexCheck = false;    // see checkTerrainVertexDecode()
+
+    bool init();
+    void renderFrame(float alpha);
+    void drawPerfOverlay();
+    void drawHud();
+    // All passes of one earlier frame, only when each timer collected its result this frame
+    bool freshGpuFrameMs(double& ms) const {
+        if (!gpuTerrain.fresh || !gpuObjects.fresh || !gpuOverlay.fresh) return false;
+        ms = gpuTerrain.lastMs + gpuObjects.lastMs + gpuOverlay.lastMs;
+        return true;
+    }
+};
 
-        float camDist = 15.0f;
-        float camHeight = 6.0f;
-        cameraPos.x = car.position.x - sin(car.rotation) * camDist;
-        cameraPos.y = car.position.y + camHeight;
-        cameraPos.z = car.position.z - cos(car.rotation) * camDist;
-        glm::vec3 lookAt = car.position + glm::vec3(0, 1, 0);
+Renderer renderer;
+
+// Runs the terrain vertex shader over a LOD 0 chunk as if it sat in pool
+// slot 1 and reads world positions back through transform feedback. Each
+// vertex must land on its own grid or skirt point of that chunk: this
+// catches gl_VertexID decoding that forgets the slot's base vertex.
+bool checkTerrainVertexDecode(const char* vertexSource) {
+    static const char* varyings[] = {"FragPos"};
+    ShaderProgram program;
+    if (!program.create(vertexSource, particleNullFragmentShader, varyings, 1)) return false;
+
+    const TerrainLod& lod = terrainLods[0];
+    const int vertexBase = 1 * lod.vertexCount;     // slot 1; pool slots hold a LOD 0 mesh
+    const int chunkX = 3, chunkZ = -2;
+    const float originX = chunkX * CHUNK_SIZE * TILE_SIZE, originZ = chunkZ * CHUNK_SIZE * TILE_SIZE;
+
+    unsigned int vao, feedback;
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &feedback);
+    glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, feedback);
+    glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, (size_t)lod.vertexCount * 3 * sizeof(float), NULL, GL_STATIC_READ);
+
+    // No arrays enabled: every attribute is the constant set here
+    glBindVertexArray(vao);
+    glVertexAttrib1f(0, 0.0f);
+    glVertexAttrib1f(1, 0.0f);
+    glVertexAttrib4f(2, originX, originZ, (float)lod.step, 1e6f);
+    glVertexAttribI1i(3, vertexBase);
+    program.use();
+    glUniform2f(program.uniform("lodFocus"), originX, originZ);
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, feedback);
+    glBeginTransformFeedback(GL_POINTS);
+    // gl_VertexID counts from `first` here exactly as it does from the
+    // base vertex of a glDrawElementsBaseVertex call
+    glDrawArrays(GL_POINTS, vertexBase, lod.vertexCount);
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glDisable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(0);
 
-        glClearColor(fogColor.r, fogColor.g, fogColor.b, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    std::vector<float> positions((size_t)lod.vertexCount * 3);
+    glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, feedback);
+    glGetBufferSubData(GL_TRANSFORM_FEEDBACK_BUFFER, 0, positions.size() * sizeof(float), positions.data());
+    glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, 0);
+    glDeleteBuffers(1, &feedback);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteProgram(program.id);
+
+    int wrong = 0, firstWrong = -1;
+    for (int v = 0; v < lod.vertexCount; v++) {
+        int x = v % lod.side, z = v / lod.side;
+        if (v >= lod.side * lod.side) skirtGridPos(v - lod.side * lod.side, lod.tiles, x, z);
+        float wantX = originX + x * lod.step * TILE_SIZE, wantZ = originZ + z * lod.step * TILE_SIZE;
+        if (std::fabs(positions[v * 3] - wantX) > 1e-3f || std::fabs(positions[v * 3 + 2] - wantZ) > 1e-3f) {
+            if (firstWrong < 0) firstWrong = v;
+            wrong++;
+        }
+    }
+    if (wrong > 0) {
+        std::cout << "Terrain vertex check failed: " << wrong << " of " << lod.vertexCount
+                  << " slot-1 vertices miss their chunk, first at vertex " << firstWrong << " ("
+                  << positions[firstWrong * 3] << ", " << positions[firstWrong * 3 + 2] << ")\n";
+    }
+    return wrong == 0;
+}
+
+bool Renderer::init() {
+    double shaderStart = nowMs();
+    std::string terrainVS = gpuTerrainMode ? withDefine(vertexShaderSource, "GPU_TERRAIN") : vertexShaderSource;
+    if (!terrainShader.create(terrainVS.c_str(), fragmentShaderSource) ||
+        !carShader.create(carVertexShader, carFragmentShader)) {
+        return false;
+    }
+    startup.shaders = nowMs() - shaderStart;
+    terrainVertexCheck = checkTerrainVertexDecode(terrainVS.c_str());
+    lodFocusLoc = terrainShader.uniform("lodFocus");
+    fogScaleLoc = carShader.uniform("fogScale");
+    frameUBO = createFrameUniformBuffer();
+    carVAO = createCarVAO();
+    staticBuildings.init();
+    particles.init();       // optional, like the text overlay
+    terrainIndexEBO = createTerrainIndexBuffer();
+
+    // Loader flags are only valid after gladLoadGL; terrain VAOs built
+    // after this point pick up the per-command attribute
+    terrainMultiDraw = terrainMultiDraw && GLAD_GL_ARB_multi_draw_indirect && GLAD_GL_ARB_base_instance;
+    if (terrainMultiDraw) {
+        glGenBuffers(1, &terrainDrawVBO);
+        glGenBuffers(1, &terrainIndirectBuffer);
+    }
+    std::cout << "Terrain submission: " << (terrainMultiDraw ? "multi-draw indirect" : "one draw per chunk") << "\n";
+
+    if (gpuTerrainMode) {
+        glGenVertexArrays(1, &proceduralTerrainVAO);
+        glBindVertexArray(proceduralTerrainVAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, terrainIndexEBO);
+        attachChunkDrawAttribute();
+        glBindVertexArray(0);
+    }
+    gpuTerrain.init();
+    gpuObjects.init();
+    gpuOverlay.init();
+    textRenderer.init();    // optional: the game runs without a font
+    return true;
+}
+
+void Renderer::drawPerfOverlay() {
+    char line[128];
+    float x = 12.0f, y = 12.0f;
+    const float lineHeight = TextRenderer::PIXEL_HEIGHT + 2.0f;
+    const glm::vec4 white(1.0f), dim(0.75f, 0.8f, 0.85f, 1.0f);
+
+    int rows = zoneStats.count + 10 + (terrainCache.enabled ? 1 : 0);
+    textRenderer.addRect(x - 6, y - 4, x + 330, y + rows * lineHeight + 4, glm::vec4(0, 0, 0, 0.55f));
+
+    snprintf(line, sizeof(line), "frame %.2f ms (%.0f fps)", deltaTime * 1000.0f, deltaTime > 0 ? 1.0f / deltaTime : 0.0f);
+    textRenderer.addText(x, y, line, white);
+    y += lineHeight;
+    snprintf(line, sizeof(line), "gpu terrain %.2f  objects %.2f  overlay %.2f ms",
+             gpuTerrain.lastMs, gpuObjects.lastMs, gpuOverlay.lastMs);
+    textRenderer.addText(x, y, line, white);
+    y += lineHeight;
+    snprintf(line, sizeof(line), "chunks %d drawn / %d culled, objects %d / %d",
+             frameStats.chunksDrawn, frameStats.chunksCulled, frameStats.objectsDrawn, frameStats.objectsCulled);
+    textRenderer.addText(x, y, line, white);
+    y += lineHeight;
+    snprintf(line, sizeof(line), "terrain triangles %d, %d draw call%s", frameStats.terrainTriangles,
+             frameStats.terrainDrawCalls, frameStats.terrainDrawCalls == 1 ? "" : "s");
+    textRenderer.addText(x, y, line, white);
+    y += lineHeight;
+    snprintf(line, sizeof(line), "object draws %d, changes: program %d, vao %d, blend %d",
+             frameStats.objectDrawCalls, frameStats.programChanges, frameStats.vaoChanges, frameStats.blendChanges);
+    textRenderer.addText(x, y, line, white);
+    y += lineHeight;
+    snprintf(line, sizeof(line), "particles %d slots, %d spawned this frame", PARTICLE_CAPACITY, frameStats.particlesSpawned);
+    textRenderer.addText(x, y, line, white);
+    y += lineHeight;
+    snprintf(line, sizeof(line), "heap allocs/frame %llu main, %llu all | arena %zu KB, peak %zu KB",
+             (unsigned long long)frameMemory.mainAllocs, (unsigned long long)frameMemory.totalAllocs,
+             frameMemory.arenaUsed / 1024, frameArena.peak / 1024);
+    textRenderer.addText(x, y, line, white);
+    y += lineHeight;
+    if (terrainCache.enabled) {
+        snprintf(line, sizeof(line), "terrain cache %zu chunks, %.1f MB, %d hits / %d misses",
+                 terrainCache.entryCount(), terrainCache.bytes() / 1e6, terrainCache.hits.load(), terrainCache.misses.load());
+        textRenderer.addText(x, y, line, white);
+        y += lineHeight;
+    }
+    y += lineHeight * 0.5f;
+
+    textRenderer.addText(x, y, "cpu ms/frame (all threads)", dim);
+    y += lineHeight;
+    for (int i = 0; i < zoneStats.count; i++) {
+        snprintf(line, sizeof(line), "  %-18s %6.3f", zoneStats.names[i], zoneStats.smoothMs[i]);
+        textRenderer.addText(x, y, line, white);
+        y += lineHeight;
+    }
+    textRenderer.addText(x, y, "F2 trace  F3 hide", dim);
+}
+
+// Survival time, score, pursuit and speed along the top of the screen
+void Renderer::drawHud() {
+    char line[96];
+    const float lineHeight = TextRenderer::HUD_PIXEL_HEIGHT + 4.0f;
+    const glm::vec4 white(1.0f), shadow(0, 0, 0, 0.6f), warn(1.0f, 0.35f, 0.25f, 1.0f);
+    float width = (float)framebufferWidth;
+
+    // Drop shadow keeps text readable on bright terrain
+    auto hudText = [&](float x, float y, const char* text, const glm::vec4& color) {
+        textRenderer.addText(x + 2, y + 2, text, shadow, TEXT_LARGE);
+        textRenderer.addText(x, y, text, color, TEXT_LARGE);
+    };
+    auto centred = [&](float y, const char* text, const glm::vec4& color) {
+        hudText((width - textRenderer.textWidth(text, TEXT_LARGE)) * 0.5f, y, text, color);
+    };
+
+    if (!gameStarted) {
+        float y = framebufferHeight * 0.35f;
+        centred(y, "GTA7 - POLICE CHASE", white);
+        centred(y + lineHeight * 1.5f, "Press ENTER to start", white);
+        snprintf(line, sizeof(line), "W/S drive  A/D steer  SPACE drift | best %ds", (int)highScore);
+        centred(y + lineHeight * 2.5f, line, glm::vec4(0.85f, 0.85f, 0.85f, 1.0f));
+        return;
+    }
 
-        float aspect = (float)framebufferWidth / (float)framebufferHeight;
-        glm::mat4 projection = glm::perspective(glm::radians(60.0f), aspect, 0.1f, 1000.0f);
-        glm::mat4 view = glm::lookAt(cameraPos, lookAt, glm::vec3(0, 1, 0));
+    snprintf(line, sizeof(line), "%ds", (int)survivalTime);
+    centred(16.0f, line, white);
+    snprintf(line, sizeof(line), "best %ds", (int)highScore);
+    centred(16.0f + lineHeight, line, glm::vec4(0.85f, 0.85f, 0.85f, 1.0f));
 
-        // Draw terrain
-        glUseProgram(terrainShader);
-        glUniformMatrix4fv(glGetUniformLocation(terrainShader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(glGetUniformLocation(terrainShader, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniform3fv(glGetUniformLocation(terrainShader, "cameraPos"), 1, glm::value_ptr(cameraPos));
-        glUniform3fv(glGetUniformLocation(terrainShader, "fogColor"), 1, glm::value_ptr(fogColor));
-        glUniform1f(glGetUniformLocation(terrainShader, "fogDensity"), fogDensity);
-        glm::mat4 model = glm::mat4(1.0f);
-        glUniformMatrix4fv(glGetUniformLocation(terrainShader, "model"), 1, GL_FALSE, glm::value_ptr(model));
+    snprintf(line, sizeof(line), "police %zu", policeCars.size());
+    hudText(width - textRenderer.textWidth(line, TEXT_LARGE) - 20.0f, 16.0f, line, policeCars.empty() ? white : warn);
 
-        for (auto& pair : chunks) {
-            glBindVertexArray(pair.second.VAO);
-            glDrawElements(GL_TRIANGLES, pair.second.indexCount, GL_UNSIGNED_INT, 0);
+    float y = framebufferHeight - lineHeight - 16.0f;
+    snprintf(line, sizeof(line), "speed %d", (int)car.speed);
+    float x = 20.0f;
+    hudText(x, y, line, white);
+    if (car.isDrifting) hudText(x + textRenderer.textWidth(line, TEXT_LARGE) + 24.0f, y, "DRIFT", glm::vec4(1.0f, 0.8f, 0.2f, 1.0f));
+}
+
+// Draws the world with sim state interpolated by alpha in [0, 1)
+void Renderer::renderFrame(float alpha) {
+    glm::vec3 carRenderPos = glm::mix(car.prevPosition, car.position, alpha);
+    float carRenderRot = glm::mix(car.prevRotation, car.rotation, alpha);
+    float carRenderDrift = glm::mix(car.prevDriftAngle, car.driftAngle, alpha);
+
+    float camDist = 15.0f;
+    float camHeight = 6.0f;
+    cameraPos.x = carRenderPos.x - sin(carRenderRot) * camDist;
+    cameraPos.y = carRenderPos.y + camHeight;
+    cameraPos.z = carRenderPos.z - cos(carRenderRot) * camDist;
+    glm::vec3 lookAt = carRenderPos + glm::vec3(0, 1, 0);
+
+    glClearColor(fogColor.r, fogColor.g, fogColor.b, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    float aspect = (float)framebufferWidth / (float)framebufferHeight;
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), aspect, 0.1f, 2000.0f);
+    glm::mat4 view = glm::lookAt(cameraPos, lookAt, glm::vec3(0, 1, 0));
+
+    Frustum frustum;
+    frustum.extract(projection * view);
+    frameStats = FrameStats();
+    int playerChunkX = (int)floor(car.position.x / (CHUNK_SIZE * TILE_SIZE));
+    int playerChunkZ = (int)floor(car.position.z / (CHUNK_SIZE * TILE_SIZE));
+
+    // Shared per-frame data for every program, uploaded once
+    FrameUniforms frameData;
+    frameData.view = view;
+    frameData.projection = projection;
+    frameData.cameraPos = cameraPos;
+    frameData.fogDensity = fogDensity;
+    frameData.fogColor = fogColor;
+    frameData.pad = 0.0f;
+    glBindBuffer(GL_UNIFORM_BUFFER, frameUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &frameData);
+
+    // Draw terrain
+    {
+        PROFILE_ZONE("render.terrain");
+        gpuTerrain.begin();
+        terrainShader.use();
+        glUniform2f(lodFocusLoc, carRenderPos.x, carRenderPos.z);
+        glBindVertexArray(gpuTerrainMode ? proceduralTerrainVAO : chunkPool.VAO);
+
+        for (const ChunkTable::Cell& cell : chunks.cells) {
+            if (!cell.resident) continue;
+            const Chunk& chunk = cell.chunk;
+            if (!isChunkVisible(frustum, chunk, playerChunkX, playerChunkZ)) continue;
+            const TerrainLod& lod = terrainLods[chunk.lod];
+            // The car sits up to half a chunk off its chunk's centre, so the last
+            // ring of a band spans LOD_MAX_RING +- 1 from it; be fully morphed by then
+            float morphEnd = chunk.lod == LOD_COUNT - 1 ? 1e6f : (float)LOD_MAX_RING[chunk.lod];
+            int baseVertex = chunk.slot >= 0 ? chunkSlots.baseVertex(chunk.slot) : 0;
+            ChunkDraw draw = {chunk.x * CHUNK_SIZE * TILE_SIZE, chunk.z * CHUNK_SIZE * TILE_SIZE, (float)lod.step, morphEnd, baseVertex};
+
+            if (terrainMultiDraw) {
+                DrawElementsIndirectCommand cmd = {(GLuint)lod.indexCount, 1, (GLuint)lod.firstIndex,
+                                                   baseVertex, (GLuint)terrainCommands.size()};
+                terrainCommands.push_back(cmd);
+                terrainDraws.push_back(draw);
+            } else {
+                glVertexAttrib4f(2, draw.originX, draw.originZ, draw.lodStep, draw.morphEnd);
+                glVertexAttribI1i(3, draw.vertexBase);
+                glDrawElementsBaseVertex(GL_TRIANGLES, lod.indexCount, GL_UNSIGNED_SHORT,
+                                         (void*)(lod.firstIndex * sizeof(unsigned short)), baseVertex);
+                frameStats.terrainDrawCalls++;
+            }
+        }
+
+        // The whole visible set in one call; buffers are orphaned each frame
+        if (!terrainCommands.empty()) {
+            glBindBuffer(GL_ARRAY_BUFFER, terrainDrawVBO);
+            glBufferData(GL_ARRAY_BUFFER, terrainDraws.size() * sizeof(ChunkDraw), terrainDraws.data(), GL_STREAM_DRAW);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, terrainIndirectBuffer);
+            glBufferData(GL_DRAW_INDIRECT_BUFFER, terrainCommands.size() * sizeof(DrawElementsIndirectCommand),
+                         terrainCommands.data(), GL_STREAM_DRAW);
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, 0, (GLsizei)terrainCommands.size(), 0);
+            frameStats.terrainDrawCalls++;
+            terrainCommands.clear();
+            terrainDraws.clear();
         }
+        gpuTerrain.end();
+    }
 
-        // --- Render Puddles (in main render loop, NOT in Car::update) ---
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    {
+        PROFILE_ZONE("render.objects");
+        gpuObjects.begin();
+        glm::mat4 model;
 
-        glUseProgram(carShader); // reuse car shader for simplicity
+        // --- Moving objects: one instance buffer per frame, one instanced draw per category ---
+        cubeInstances.clear();
+        auto addCube = [&](const glm::mat4& m, const glm::vec3& color) {
+            if (isCubeVisible(frustum, m)) cubeInstances.push_back({m, color});
+        };
 
+        CubeBatch puddleBatch = {cubeInstances.size(), 0};
         for (const auto& p : puddles) {
-            float y = getTerrainHeight(p.pos.x, p.pos.y) + 0.01f;
-            glm::mat4 model = glm::mat4(1.0f);
+            float y = sampleTerrainHeight(p.pos.x, p.pos.y) + 0.01f;
+            model = glm::mat4(1.0f);
             model = glm::translate(model, glm::vec3(p.pos.x, y, p.pos.y));
             model = glm::scale(model, glm::vec3(p.radius, 0.01f, p.radius)); // flatten
+            addCube(model, glm::vec3(0.3f, 0.5f, 1.0f)); // blue
+        }
+        puddleBatch.count = cubeInstances.size() - puddleBatch.first;
 
-            glUniformMatrix4fv(glGetUniformLocation(carShader, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glUniformMatrix4fv(glGetUniformLocation(carShader, "view"), 1, GL_FALSE, glm::value_ptr(view));
-            glUniformMatrix4fv(glGetUniformLocation(carShader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-            glUniform3f(glGetUniformLocation(carShader, "carColor"), 0.3f, 0.5f, 1.0f); // blue
-            glUniform1f(glGetUniformLocation(carShader, "fogDensity"), 0.0f);
-            glUniform3fv(glGetUniformLocation(carShader, "cameraPos"), 1, glm::value_ptr(cameraPos));
-            glUniform3fv(glGetUniformLocation(carShader, "fogColor"), 1, glm::value_ptr(fogColor));
+        // Player car is always on screen
+        CubeBatch carBatch = {cubeInstances.size(), 1};
+        model = glm::mat4(1.0f);
+        model = glm::translate(model, carRenderPos);
+        model = glm::rotate(model, carRenderRot, glm::vec3(0, 1, 0));
+        model = glm::rotate(model, carRenderDrift, glm::vec3(0, 1, 0));
+        cubeInstances.push_back({model, glm::vec3(0.9f, 0.1f, 0.1f)});
+
+        CubeBatch copBatch = {cubeInstances.size(), 0};
+        const float* copRot = policeCars[COP_ROTATION];
+        const float* copPrevRot = policeCars[COP_PREV_ROTATION];
+        for (size_t i = 0; i < policeCars.size(); i++) {
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::mix(policeCars.vec3(COP_PREV_X, i), policeCars.vec3(COP_X, i), alpha));
+            model = glm::rotate(model, glm::mix(copPrevRot[i], copRot[i], alpha), glm::vec3(0, 1, 0));
+            addCube(model, glm::vec3(0.1f, 0.1f, 0.9f));
+        }
+        copBatch.count = cubeInstances.size() - copBatch.first;
+
+        // Bullets are drawn as tracers by the particle system
+        uploadCubeInstances(cubeInstances);
+
+        DrawItem cubes = {};
+        cubes.program = carShader.id;
+        cubes.vao = carVAO;
+        cubes.blend = BLEND_OPAQUE;
+        cubes.fogLoc = fogScaleLoc;
+        cubes.fog = 1.0f;
+        for (const CubeBatch* batch : {&carBatch, &copBatch}) {
+            if (batch->count == 0) continue;
+            cubes.firstInstance = batch->first;
+            cubes.instanceCount = (GLsizei)batch->count;
+            queue.submit(cubes, 0.0f);
+        }
 
-            glBindVertexArray(carVAO); // or create a flat quad VAO later
-            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+        // Puddles: translucent, unfogged, one item each so they sort back to front
+        DrawItem puddle = cubes;
+        puddle.blend = BLEND_ALPHA;
+        puddle.fog = 0.0f;
+        puddle.instanceCount = 1;
+        for (size_t i = puddleBatch.first; i < puddleBatch.first + puddleBatch.count; i++) {
+            puddle.firstInstance = i;
+            queue.submit(puddle, glm::length(glm::vec3(cubeInstances[i].model[3]) - cameraPos));
         }
 
-        glDisable(GL_BLEND);
+        // Buildings: one static mesh per chunk, culled and depth-sorted whole
+        staticBuildings.update();
+        DrawItem building = cubes;
+        building.vao = staticBuildings.VAO;
+        building.instanceCount = 0;
+        for (const StaticBatch& batch : staticBuildings.batches) {
+            glm::vec3 centre = (batch.boundsMin + batch.boundsMax) * 0.5f;
+            float radius = glm::length(batch.boundsMax - centre);
+            float dist = glm::length(centre - cameraPos);
+            if (dist - radius > MAX_DRAW_DISTANCE || !frustum.intersectsAABB(batch.boundsMin, batch.boundsMax)) {
+                frameStats.objectsCulled += batch.buildingCount;
+                continue;
+            }
+            frameStats.objectsDrawn += batch.buildingCount;
+            building.firstIndex = batch.firstIndex;
+            building.indexCount = batch.indexCount;
+            queue.submit(building, std::max(dist - radius, 0.0f));
+        }
 
+        queue.flush();
 
-        
+        // After the queue: blended over everything opaque and the puddles
+        particles.update(deltaTime, alpha);
+        particles.draw();
+        gpuObjects.end();
+    }
 
+    {
+        PROFILE_ZONE("render.overlay");
+        gpuOverlay.begin();
+        drawHud();
+        if (showPerfOverlay) drawPerfOverlay();
+        textRenderer.flush(framebufferWidth, framebufferHeight);
+        gpuOverlay.end();
+    }
+}
 
+// ============ INPUT RECORDING ============
+// The sim is a fixed-timestep function of the seed and the per-tick input,
+// so a run is reproduced by recording exactly those. File layout, little
+// endian: "GT7I", u32 version, u32 seed, then runs of (u8 key bits, u16 ticks)
+// to the end of the file. Held keys make long runs: an hour of driving is a
+// few tens of KB.
+
+const char INPUT_LOG_MAGIC[4] = {'G', 'T', '7', 'I'};
+const uint32_t INPUT_LOG_VERSION = 1;
+const uint32_t INPUT_RUN_MAX = 0xFFFF;
+
+enum InputBit {
+    INPUT_FORWARD = 1 << 0,
+    INPUT_BACKWARD = 1 << 1,
+    INPUT_LEFT = 1 << 2,
+    INPUT_RIGHT = 1 << 3,
+    INPUT_DRIFT = 1 << 4,
+    INPUT_START = 1 << 5,
+};
 
-        // Draw player car
-        glUseProgram(carShader);
-        glUniform3fv(glGetUniformLocation(carShader, "cameraPos"), 1, glm::value_ptr(cameraPos));
-        glUniform3fv(glGetUniformLocation(carShader, "fogColor"), 1, glm::value_ptr(fogColor));
-        glUniform1f(glGetUniformLocation(carShader, "fogDensity"), fogDensity);
-        
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, car.position);
-        model = glm::rotate(model, car.rotation, glm::vec3(0, 1, 0));
-        model = glm::rotate(model, car.driftAngle, glm::vec3(0, 1, 0));
-        glUniformMatrix4fv(glGetUniformLocation(carShader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(glGetUniformLocation(carShader, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(carShader, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glUniform3f(glGetUniformLocation(carShader, "carColor"), 0.9f, 0.1f, 0.1f);
-        
-        glBindVertexArray(carVAO);
-        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+uint8_t packInput(const InputState& in) {
+    return (in.forward ? INPUT_FORWARD : 0) | (in.backward ? INPUT_BACKWARD : 0) |
+           (in.left ? INPUT_LEFT : 0) | (in.right ? INPUT_RIGHT : 0) |
+           (in.drift ? INPUT_DRIFT : 0) | (in.start ? INPUT_START : 0);
+}
 
-        // Draw police cars
-        for (auto& cop : policeCars) {
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, cop.position);
-            model = glm::rotate(model, cop.rotation, glm::vec3(0, 1, 0));
-            glUniformMatrix4fv(glGetUniformLocation(carShader, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glUniform3f(glGetUniformLocation(carShader, "carColor"), 0.1f, 0.1f, 0.9f);
-            glBindVertexArray(carVAO);
-            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-        }
-
-        // Draw buildings
-        glUseProgram(carShader);
-        glUniform3f(glGetUniformLocation(carShader, "carColor"), 0.4f, 0.4f, 0.4f); // gray
-        for (const auto& b : buildings) {
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, b.position);
-            model = glm::scale(model, glm::vec3(b.width, b.height, b.depth));
-            glUniformMatrix4fv(glGetUniformLocation(carShader, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glUniformMatrix4fv(glGetUniformLocation(carShader, "view"), 1, GL_FALSE, glm::value_ptr(view));
-            glUniformMatrix4fv(glGetUniformLocation(carShader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-            glUniform3fv(glGetUniformLocation(carShader, "cameraPos"), 1, glm::value_ptr(cameraPos));
-            glUniform3fv(glGetUniformLocation(carShader, "fogColor"), 1, glm::value_ptr(fogColor));
-            glUniform1f(glGetUniformLocation(carShader, "fogDensity"), fogDensity);
-            glBindVertexArray(carVAO); // reuse car VAO (cube)
-            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+InputState unpackInput(uint8_t bits) {
+    InputState in;
+    in.forward = bits & INPUT_FORWARD;
+    in.backward = bits & INPUT_BACKWARD;
+    in.left = bits & INPUT_LEFT;
+    in.right = bits & INPUT_RIGHT;
+    in.drift = bits & INPUT_DRIFT;
+    in.start = bits & INPUT_START;
+    return in;
+}
+
+struct InputRecorder {
+    std::ofstream file;
+    uint8_t runKeys = 0;
+    uint32_t runTicks = 0;
+    uint64_t ticks = 0;
+
+    bool active() const { return file.is_open(); }
+    bool open(const std::string& path, uint32_t seed);
+    void record(const InputState& input);      // once per sim tick, before it runs
+    void close();
+    void writeRun();
+};
+
+InputRecorder inputRecorder;
+
+bool InputRecorder::open(const std::string& path, uint32_t seed) {
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    file.write(INPUT_LOG_MAGIC, 4);
+    file.write(reinterpret_cast<const char*>(&INPUT_LOG_VERSION), sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(&seed), sizeof(uint32_t));
+    return true;
+}
+
+void InputRecorder::writeRun() {
+    uint16_t count = (uint16_t)runTicks;
+    file.write(reinterpret_cast<const char*>(&runKeys), 1);
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+}
+
+void InputRecorder::record(const InputState& input) {
+    uint8_t keys = packInput(input);
+    if (runTicks > 0 && (keys != runKeys || runTicks == INPUT_RUN_MAX)) {
+        writeRun();
+        runTicks = 0;
+    }
+    runKeys = keys;
+    runTicks++;
+    ticks++;
+}
+
+void InputRecorder::close() {
+    if (!active()) return;
+    if (runTicks > 0) writeRun();
+    runTicks = 0;
+    file.close();
+}
+
+struct InputReplay {
+    struct Run {
+        uint8_t keys;
+        uint16_t ticks;
+    };
+    std::vector<Run> runs;
+    uint32_t seed = 0;
+    uint64_t totalTicks = 0;
+    size_t run = 0;             // playback position
+    uint32_t tickInRun = 0;
+
+    bool load(const std::string& path);
+    bool next(InputState& input);       // false once the log is exhausted
+};
+
+bool InputReplay::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[4];
+    uint32_t version = 0;
+    in.read(magic, 4);
+    in.read(reinterpret_cast<char*>(&version), sizeof(version));
+    in.read(reinterpret_cast<char*>(&seed), sizeof(seed));
+    if (!in || memcmp(magic, INPUT_LOG_MAGIC, 4) != 0 || version != INPUT_LOG_VERSION) return false;
+
+    runs.clear();
+    totalTicks = 0;
+    Run r;
+    while (in.read(reinterpret_cast<char*>(&r.keys), 1) && in.read(reinterpret_cast<char*>(&r.ticks), sizeof(r.ticks))) {
+        if (r.ticks == 0) continue;
+        runs.push_back(r);
+        totalTicks += r.ticks;
+    }
+    run = 0;
+    tickInRun = 0;
+    return true;
+}
+
+bool InputReplay::next(InputState& input) {
+    if (run >= runs.size()) return false;
+    input = unpackInput(runs[run].keys);
+    if (++tickInRun == runs[run].ticks) {
+        run++;
+        tickInRun = 0;
+    }
+    return true;
+}
+
+InputReplay inputReplay;
+
+// ============ BENCHMARK ============
+// GTA7 --bench [--headless] runs a fixed, seeded workload: the car loops a
+// scripted high-speed path across many chunk boundaries while a set number
+// of cops chase it and bullets are kept in flight. Each frame advances a
+// fixed 1/60s of simulation so runs are comparable; wall-clock times go to
+// a JSON (or .csv) report. --replay drives the same loop and report from a
+// recorded input log instead of the scripted path.
+
+struct LaunchOptions {
+    bool bench = false;
+    bool headless = false;
+    bool gpuTerrain = false;
+    bool multiDraw = true;          // used when the driver supports it
+    unsigned int seed = 1337;
+    bool seedGiven = false;
+    int frames = 0;                 // 0: 3600 for the benchmark, the whole log for a replay
+    int ticksPerFrame = 2;          // sim ticks per benchmark frame; raise to replay faster than real time
+    int cops = 8;
+    int bullets = 40;
+    int simThreads = -1;            // helper threads for the sim update, -1 picks from the core count
+    std::string outPath = "bench_report.json";
+    std::string tracePath;          // Chrome trace written at exit when set
+    std::string terrainCachePath;   // on-disk chunk cache, off when empty
+    bool shaderCache = true;        // reuse linked program binaries across launches
+    std::string recordPath;         // game: write the seed and per-tick input here
+    std::string replayPath;         // benchmark driven by a recorded input log
+};
+
+void printUsage() {
+    std::cout << "Usage: GTA7 [options]\n"
+              << "  --bench            run the scripted benchmark instead of the game\n"
+              << "  --headless         benchmark without a window or GL context\n"
+              << "  --gpu-terrain      compute terrain heights in the vertex shader\n"
+              << "  --no-mdi           draw terrain chunk by chunk even if multi-draw indirect exists\n"
+              << "  --seed N           RNG seed for the benchmark (default 1337)\n"
+              << "  --frames N         benchmark length in frames (default 3600; replays run to the end)\n"
+              << "  --ticks-per-frame N  sim ticks per benchmark frame (default 2, 1/60s)\n"
+              << "  --cops N           police cars spawned at start (default 8, max 4096)\n"
+              << "  --bullets N        bullets kept in flight (default 40, max 65536)\n"
+              << "  --sim-threads N    helper threads for the AI/bullet update (default: cores - 1)\n"
+              << "  --terrain-kernel K terrain sampler: scalar, sse2, avx2 or neon (default: widest the CPU runs)\n"
+              << "  --out PATH         report file, .json or .csv (default bench_report.json)\n"
+              << "  --trace PATH       write a Chrome trace (chrome://tracing) on exit\n"
+              << "  --terrain-cache PATH  load/save generated chunk heights in PATH\n"
+              << "  --no-shader-cache  always compile shaders from source\n"
+              << "  --record PATH      play normally, recording the seed and input to PATH\n"
+              << "  --replay PATH      benchmark a recorded session (implies --bench)\n"
+              << "  --help             show this message\n";
+}
+
+// Returns false when the program should exit right away (help or bad args)
+bool parseLaunchOptions(int argc, char** argv, LaunchOptions& opt, int& exitCode) {
+    exitCode = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool missingValue = false;
+        auto value = [&](const char* name) -> const char* {
+            if (i + 1 < argc) return argv[++i];
+            std::cout << name << " needs a value\n";
+            missingValue = true;
+            return nullptr;
+        };
+        const char* v = nullptr;
+        if (arg == "--help" || arg == "-h") { printUsage(); return false; }
+        else if (arg == "--bench") opt.bench = true;
+        else if (arg == "--headless") opt.headless = true;
+        else if (arg == "--gpu-terrain") opt.gpuTerrain = true;
+        else if (arg == "--no-mdi") opt.multiDraw = false;
+        else if (arg == "--no-shader-cache") opt.shaderCache = false;
+        else if (arg == "--seed" && (v = value("--seed"))) { opt.seed = (unsigned int)std::stoul(v); opt.seedGiven = true; }
+        else if (arg == "--frames" && (v = value("--frames"))) opt.frames = std::max(1, std::atoi(v));
+        else if (arg == "--ticks-per-frame" && (v = value("--ticks-per-frame"))) opt.ticksPerFrame = std::max(1, std::atoi(v));
+        else if (arg == "--cops" && (v = value("--cops"))) opt.cops = std::min(std::max(0, std::atoi(v)), (int)MAX_COPS);
+        else if (arg == "--bullets" && (v = value("--bullets"))) opt.bullets = std::min(std::max(0, std::atoi(v)), (int)MAX_BULLETS);
+        else if (arg == "--sim-threads" && (v = value("--sim-threads"))) opt.simThreads = std::max(0, std::atoi(v));
+        else if (arg == "--terrain-kernel" && (v = value("--terrain-kernel"))) {
+            int k = 0;
+            while (k < TERRAIN_KERNEL_COUNT && std::strcmp(v, terrainKernelName((TerrainKernel)k)) != 0) k++;
+            if (k == TERRAIN_KERNEL_COUNT || !terrainKernelSupported((TerrainKernel)k)) {
+                std::cout << "Terrain kernel " << v << " is not available on this build or CPU\n";
+                exitCode = 1;
+                return false;
+            }
+            setTerrainKernel((TerrainKernel)k);
         }
-        
-        // Draw bullets (as small red cubes)
-        for (auto& b : bullets) {
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, b.pos);
-            model = glm::scale(model, glm::vec3(0.2f));
-            glUniformMatrix4fv(glGetUniformLocation(carShader, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glUniform3f(glGetUniformLocation(carShader, "carColor"), 1.0f, 0.0f, 0.0f);
-            glBindVertexArray(carVAO);
-            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-        }
-
-        // Print HUD to console (in a real game you'd render to screen)
-        if (gameStarted) {
-            static float printTimer = 0;
-            printTimer += deltaTime;
-            if (printTimer > 1.0f) {
-                std::cout << "Time: " << (int)survivalTime << "s | High Score: " << (int)highScore 
-                         << "s | Police: " << policeCars.size() << " | Speed: " << (int)car.speed 
-                         << (car.isDrifting ? " [DRIFT]" : "") << "\n";
-                printTimer = 0;
+        else if (arg == "--out" && (v = value("--out"))) opt.outPath = v;
+        else if (arg == "--trace" && (v = value("--trace"))) opt.tracePath = v;
+        else if (arg == "--terrain-cache" && (v = value("--terrain-cache"))) opt.terrainCachePath = v;
+        else if (arg == "--record" && (v = value("--record"))) opt.recordPath = v;
+        else if (arg == "--replay" && (v = value("--replay"))) { opt.replayPath = v; opt.bench = true; }
+        else {
+            if (!missingValue) std::cout << "Unknown option: " << arg << "\n";
+            printUsage();
+            exitCode = 1;
+            return false;
+        }
+    }
+    if (opt.headless && !opt.bench) {
+        std::cout << "--headless only applies to --bench\n";
+        exitCode = 1;
+        return false;
+    }
+    if (!opt.recordPath.empty() && opt.bench) {
+        std::cout << "--record only applies to the game\n";
+        exitCode = 1;
+        return false;
+    }
+    return true;
+}
+
+void writeTraceIfRequested(const LaunchOptions& opt) {
+    if (opt.tracePath.empty()) return;
+    if (profiler.writeChromeTrace(opt.tracePath.c_str()))
+        std::cout << "Trace written to " << opt.tracePath << "\n";
+    else
+        std::cout << "Failed to write trace " << opt.tracePath << "\n";
+}
+
+struct TimingSummary {
+    double min = 0, avg = 0, p99 = 0, max = 0;
+};
+
+TimingSummary summarize(std::vector<double> samples) {
+    TimingSummary t;
+    if (samples.empty()) return t;
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double v : samples) sum += v;
+    t.min = samples.front();
+    t.max = samples.back();
+    t.avg = sum / samples.size();
+    t.p99 = samples[std::min(samples.size() - 1, (size_t)(samples.size() * 0.99))];
+    return t;
+}
+
+int runBenchmark(const LaunchOptions& opt, GLFWwindow* window) {
+    const int ticksPerFrame = opt.ticksPerFrame;
+    const bool replaying = !opt.replayPath.empty();
+    int frameLimit = opt.frames;
+    if (frameLimit == 0) {
+        frameLimit = replaying ? (int)((inputReplay.totalTicks + ticksPerFrame - 1) / ticksPerFrame) : 3600;
+    }
+
+    // A replay starts from launch state and presses ENTER itself
+    if (!replaying) {
+        scriptedDrive.active = true;
+        startGame();
+        for (int i = 0; i < opt.cops; i++) spawnPoliceCar();
+    }
+
+    if (window) glfwSwapInterval(0);
+
+    InputState input;
+    input.forward = true;
+
+    std::vector<double> frameMs, gpuMs;
+    frameMs.reserve(frameLimit);
+    double physicsMs = 0, streamMs = 0, renderMs = 0;
+    long long buildNanosAtStart = chunkWorkers.buildNanos;
+    int chunksAtStart = chunkWorkers.chunksBuilt;
+    uint64_t mainAllocs = 0, totalAllocs = 0, mainAllocsMax = 0;
+    endFrameMemory();   // setup allocations stay out of the first frame
+
+    if (replaying) {
+        std::cout << "Replay: " << opt.replayPath << ", " << inputReplay.totalTicks << " ticks ("
+                  << inputReplay.totalTicks * SIM_DT << " s), seed " << inputReplay.seed;
+    } else {
+        std::cout << "Benchmark: " << frameLimit << " frames, seed " << opt.seed;
+    }
+    std::cout << (window ? "" : ", headless") << ", " << terrainKernelName(activeTerrainKernel()) << " terrain kernel\n";
+
+    int frames = 0;
+    bool logEnded = false;
+    for (; frames < frameLimit && !logEnded; frames++) {
+        if (window && glfwWindowShouldClose(window)) break;
+        double frameStart = nowMs();
+
+        for (int t = 0; t < ticksPerFrame; t++) {
+            if (replaying) {
+                if (!inputReplay.next(input)) {
+                    logEnded = true;
+                    break;
+                }
+            } else if (!policeCars.empty()) {
+                std::uniform_int_distribution<size_t> pick(0, policeCars.size() - 1);
+                while ((int)bullets.size() < opt.bullets) fireBullet(pick(gen));
             }
+            simulateTick(input, SIM_DT);
+        }
+        flushSounds();
+        double simEnd = nowMs();
+
+        updateChunks();
+        double streamEnd = nowMs();
+
+        if (window) {
+            deltaTime = ticksPerFrame * SIM_DT;     // sim time, so effects age the same on every machine
+            renderer.renderFrame(1.0f);
+            double gpuFrame;
+            if (renderer.freshGpuFrameMs(gpuFrame)) gpuMs.push_back(gpuFrame);
+        }
+        startup.noteFrame();
+        double renderEnd = nowMs();
+
+        if (window) {
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+        endFrameMemory();
+        mainAllocs += frameMemory.mainAllocs;
+        totalAllocs += frameMemory.totalAllocs;
+        mainAllocsMax = std::max(mainAllocsMax, frameMemory.mainAllocs);
+
+        physicsMs += simEnd - frameStart;
+        streamMs += streamEnd - simEnd;
+        renderMs += renderEnd - streamEnd;
+        frameMs.push_back(nowMs() - frameStart);
+    }
+
+    TimingSummary frame = summarize(frameMs);
+    TimingSummary gpu = summarize(gpuMs);
+    int chunksBuilt = chunkWorkers.chunksBuilt - chunksAtStart;
+    double chunkGenMs = (chunkWorkers.buildNanos - buildNanosAtStart) / 1e6;
+    double n = std::max(frames, 1);
+
+    bool csv = opt.outPath.size() >= 4 && opt.outPath.compare(opt.outPath.size() - 4, 4, ".csv") == 0;
+    std::ofstream out(opt.outPath);
+    if (csv) {
+        out << "seed,frames,headless,gpu_terrain,cops,bullets,sim_threads,frame_min_ms,frame_avg_ms,frame_p99_ms,frame_max_ms,"
+               "physics_ms,chunk_stream_ms,render_submit_ms,chunk_gen_worker_ms,chunks_built,"
+               "chunk_gen_ms_per_chunk,startup_first_frame_ms,startup_near_chunks_ms,gpu_avg_ms,gpu_p99_ms\n";
+        out << (replaying ? inputReplay.seed : opt.seed) << "," << frames << "," << (window ? 0 : 1) << "," << (opt.gpuTerrain ? 1 : 0) << "," << opt.cops << "," << opt.bullets << "," << simJobs.workers.size() << ","
+            << frame.min << "," << frame.avg << "," << frame.p99 << "," << frame.max << ","
+            << physicsMs / n << "," << streamMs / n << "," << renderMs / n << ","
+            << chunkGenMs / n << "," << chunksBuilt << "," << chunkGenMs / std::max(chunksBuilt, 1) << ","
+            << startup.firstFrame << "," << startup.nearChunks << ",";
+        if (gpuMs.empty()) out << ",\n";
+        else out << gpu.avg << "," << gpu.p99 << "\n";
+    } else {
+        out << "{\n"
+            << "  \"seed\": " << (replaying ? inputReplay.seed : opt.seed) << ",\n"
+            << "  \"replay\": ";
+        if (replaying) out << "\"" << opt.replayPath << "\",\n";
+        else out << "null,\n";
+        out << "  \"frames\": " << frames << ",\n"
+            << "  \"sim_seconds\": " << simTime << ",\n"
+            << "  \"headless\": " << (window ? "false" : "true") << ",\n"
+            << "  \"terrain\": \"" << (opt.gpuTerrain ? "gpu" : "cpu") << "\",\n"
+            << "  \"cops\": " << opt.cops << ",\n"
+            << "  \"bullets\": " << opt.bullets << ",\n"
+            << "  \"sim_threads\": " << simJobs.workers.size() << ",\n"
+            << "  \"terrain_kernel\": \"" << terrainKernelName(activeTerrainKernel()) << "\",\n"
+            << "  \"frame_ms\": {\"min\": " << frame.min << ", \"avg\": " << frame.avg
+            << ", \"p99\": " << frame.p99 << ", \"max\": " << frame.max << "},\n"
+            << "  \"cpu_ms_per_frame\": {\"physics\": " << physicsMs / n << ", \"chunk_stream\": " << streamMs / n
+            << ", \"render_submit\": " << renderMs / n << ", \"chunk_gen_worker\": " << chunkGenMs / n << "},\n"
+            << "  \"chunk_gen\": {\"chunks_built\": " << chunksBuilt
+            << ", \"ms_per_chunk\": " << chunkGenMs / std::max(chunksBuilt, 1) << "},\n"
+            << "  \"memory\": {\"heap_allocs_per_frame\": {\"main_avg\": " << mainAllocs / n
+            << ", \"main_max\": " << mainAllocsMax << ", \"all_threads_avg\": " << totalAllocs / n
+            << "}, \"frame_arena_peak_kb\": " << frameArena.peak / 1024.0 << ", \"frame_arena_overflows\": " << frameArena.overflows
+            << ", \"pool_rejects\": {\"cops\": " << policeCars.rejected << ", \"bullets\": " << bullets.rejected << "}},\n"
+            << "  \"startup_ms\": {\"window\": " << startup.window << ", \"renderer\": " << startup.renderer
+            << ", \"shaders\": " << startup.shaders << ", \"world\": " << startup.world
+            << ", \"first_frame\": " << startup.firstFrame << ", \"near_chunks\": " << startup.nearChunks << "},\n"
+            << "  \"shader_cache\": ";
+        if (!programCache.enabled) out << "null,\n";
+        else out << "{\"hits\": " << programCache.hits << ", \"misses\": " << programCache.misses << "},\n";
+        out << "  \"terrain_cache\": ";
+        if (!terrainCache.enabled) out << "null,\n";
+        else out << "{\"chunks\": " << terrainCache.entryCount() << ", \"mb\": " << terrainCache.bytes() / 1e6
+                 << ", \"hits\": " << terrainCache.hits << ", \"misses\": " << terrainCache.misses << "},\n";
+        out << "  \"terrain_vertex_check\": " << (!window ? "null" : renderer.terrainVertexCheck ? "true" : "false") << ",\n";
+        out << "  \"gpu_ms\": ";
+        if (gpuMs.empty()) out << "null\n";
+        else out << "{\"avg\": " << gpu.avg << ", \"p99\": " << gpu.p99 << ", \"max\": " << gpu.max << "}\n";
+        out << "}\n";
+    }
+
+    logger.flush();     // keep the summary after the run's log lines
+    if (replaying) {
+        // Same log, same build: these match run to run, whatever the thread count
+        std::cout << "Replay end state: survival " << survivalTime << " s, car (" << car.position.x << ", "
+                  << car.position.z << "), " << policeCars.size() << " cops, " << bullets.size() << " bullets\n";
+    }
+    std::cout << "Frame ms min/avg/p99/max: " << frame.min << " / " << frame.avg << " / "
+              << frame.p99 << " / " << frame.max << "\n"
+              << "Report written to " << opt.outPath << "\n";
+    if (window && !renderer.terrainVertexCheck) return 1;     // terrain would draw at the wrong place
+    return out ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    startup.launch = nowMs();
+    LaunchOptions options;
+    int exitCode = 0;
+    if (!parseLaunchOptions(argc, argv, options, exitCode)) return exitCode;
+
+    // Benchmarks and recordings are reproducible: a known seed instead of std::random_device
+    if (!options.replayPath.empty()) {
+        if (!inputReplay.load(options.replayPath)) {
+            std::cout << "Failed to read input log " << options.replayPath << "\n";
+            return 1;
+        }
+        gen.seed(inputReplay.seed);
+    } else if (options.bench) {
+        gen.seed(options.seed);
+    } else if (!options.recordPath.empty()) {
+        uint32_t seed = options.seedGiven ? options.seed : rd();
+        if (!inputRecorder.open(options.recordPath, seed)) {
+            std::cout << "Failed to open " << options.recordPath << " for recording\n";
+            return 1;
+        }
+        gen.seed(seed);
+    } else if (options.seedGiven) {
+        gen.seed(options.seed);
+    }
+    headlessMode = options.headless;
+    gpuTerrainMode = options.gpuTerrain;
+    terrainMultiDraw = options.multiDraw;   // narrowed to driver support in Renderer::init
+    initTerrainLods();
+
+    GLFWwindow* window = nullptr;
+    if (!headlessMode) {
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+        window = glfwCreateWindow(1280, 720, "GTA7 - Police Chase", NULL, NULL);
+        if (!window) {
+            std::cout << "Failed to create window\n";
+            glfwTerminate();
+            return -1;
         }
+        glfwMakeContextCurrent(window);
+
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            std::cout << "Failed to initialize GLAD\n";
+            return -1;
+        }
+
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        glViewport(0, 0, framebufferWidth, framebufferHeight);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        glEnable(GL_DEPTH_TEST);
+
+        // Put a frame up before anything slow happens
+        glClearColor(fogColor.r, fogColor.g, fogColor.b, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glfwSwapBuffers(window);
+        startup.window = nowMs() - startup.launch;
+
+        double rendererStart = nowMs();
+        if (options.shaderCache) programCache.open("gta7_shader_cache.bin");
+        if (!renderer.init()) {
+            glfwTerminate();
+            return -1;
+        }
+        programCache.save();
+        startup.renderer = nowMs() - rendererStart;
+    }
+
+    // No audio while benchmarking
+    if (!options.bench) audio.init();
+
+    double worldStart = nowMs();
+    unsigned int hwThreads = std::thread::hardware_concurrency();
+    int workerCount = hwThreads > 1 ? (int)std::min(hwThreads - 1, 4u) : 1;
+    if (!gpuTerrainMode) {
+        // Every chunk the keep window can hold, plus one so a LOD rebuild can
+        // upload before releasing the slot it replaces
+        int keepSide = 2 * CHUNK_KEEP_RADIUS + 1;
+        chunkPool.init(keepSide * keepSide + 1);
+        if (!options.terrainCachePath.empty()) {
+            terrainCache.open(options.terrainCachePath);
+            terrainCache.startWarming(0, 0, CHUNK_KEEP_RADIUS);     // the car spawns at the origin
+        }
+        uploadQueue.reserve(CHUNK_MESH_RECORDS);
+        chunkWorkers.start(workerCount);
+    }
+    simJobs.start(options.simThreads >= 0 ? options.simThreads : (int)std::min(std::max(hwThreads, 1u) - 1, 8u));
+    
+    car.position.y = sampleTerrainHeight(0, 0) + 0.5f;
+    car.savePrevious();
+    // Scenery is placed up front so pressing ENTER only resets the run
+    spawnPuddles();
+    spawnBuildings();
+    startup.world = nowMs() - worldStart;
+
+    // Everything from here to shutdown logs through the async sink
+    logger.start();
+
+    if (options.bench) {
+        exitCode = runBenchmark(options, window);
+        logger.stop();
+        chunkWorkers.stop();
+        simJobs.stop();
+        terrainCache.close();
+        writeTraceIfRequested(options);
+        if (window) glfwTerminate();
+        return exitCode;
+    }
+    
+    LOG_INFO("\n=== GTA7 - POLICE CHASE ===");
+    LOG_INFO("Press ENTER to start");
+    LOG_INFO("W/S - Accelerate/Brake");
+    LOG_INFO("A/D - Steer");
+    LOG_INFO("SPACE - Drift (NFS style!)");
+    LOG_INFO("Avoid police cars and bullets!\n");
+
+    float lastFrame = glfwGetTime();
+
+    while (!glfwWindowShouldClose(window)) {
+        float currentFrame = glfwGetTime();
+        deltaTime = currentFrame - lastFrame;
+        deltaTime = fminf(deltaTime, 0.1f);
+        lastFrame = currentFrame;
+        InputState input = processInput(window);
+        
+        updateAudio(deltaTime);
+        
+        simAccumulator += deltaTime;
+        int simSteps = 0;
+        while (simAccumulator >= SIM_DT && simSteps < MAX_SIM_STEPS_PER_FRAME) {
+            if (inputRecorder.active()) inputRecorder.record(input);
+            simulateTick(input, SIM_DT);
+            simAccumulator -= SIM_DT;
+            simSteps++;
+        }
+        if (simAccumulator >= SIM_DT) simAccumulator = fmodf(simAccumulator, SIM_DT);
+        flushSounds();
+
+        updateChunks();
+
+        // Render between the last two sim states
+        renderer.renderFrame(simAccumulator / SIM_DT);
+        startup.noteFrame();
 
         glfwSwapBuffers(window);
         glfwPollEvents();
+        endFrameMemory();
+
+        zoneStats.collect(profiler);
+        zoneStats.endFrame();
     }
 
-    if (isEngineLoaded) ma_sound_uninit(&engineSound);
-    ma_engine_uninit(&engine);
+    logger.stop();
+    chunkWorkers.stop();
+    simJobs.stop();
+    terrainCache.close();
+    inputRecorder.close();
+    writeTraceIfRequested(options);
+
+    audio.shutdown();
     glfwTerminate();
     return 0;
 }
@@ -0,0 +1,190 @@
+#include "chunk_mesh.h"
+
+#include "profiler.h"
+#include "terrain_cache.h"
+#include "terrain_noise.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+ChunkWorkerPool chunkWorkers;
+
+void buildChunkMesh(int chunkX, int chunkZ, int lod, ChunkMesh& mesh, LinearArena& scratch) {
+    PROFILE_ZONE("buildChunkMesh");
+    const TerrainLod& l = terrainLods[lod];
+    const int side = l.side, gridVerts = side * side;
+    mesh.x = chunkX;
+    mesh.z = chunkZ;
+    mesh.lod = lod;
+    mesh.vertexCount = l.vertexCount;
+    scratch.reset();
+
+    float* heights = mesh.heights;
+    if (terrainCache.enabled) {
+        // Cache records are full resolution; LOD grid points are a subset
+        float* full = scratch.allocArray<float>(FULL_GRID_VERTS);
+        sampleChunkHeights(chunkX, chunkZ, full);
+        for (int z = 0; z < side; z++) {
+            for (int x = 0; x < side; x++) {
+                heights[z * side + x] = full[z * l.step * FULL_GRID_SIDE + x * l.step];
+            }
+        }
+    } else {
+        // Sample the whole grid in one batch
+        float* gridX = scratch.allocArray<float>(gridVerts);
+        float* gridZ = scratch.allocArray<float>(gridVerts);
+        for (int z = 0; z < side; z++) {
+            for (int x = 0; x < side; x++) {
+                gridX[z * side + x] = (chunkX * CHUNK_SIZE + x * l.step) * TILE_SIZE;
+                gridZ[z * side + x] = (chunkZ * CHUNK_SIZE + z * l.step) * TILE_SIZE;
+            }
+        }
+        getTerrainHeightBatch(gridX, gridZ, heights, gridVerts);
+    }
+
+    // Morph target: the next LOD's triangle under each vertex. Odd vertices
+    // lie on a coarse edge or on the coarse quad's topRight-bottomLeft diagonal.
+    auto h = [&](int x, int z) { return heights[z * side + x]; };
+    auto morphHeight = [&](int x, int z) {
+        if (lod == LOD_COUNT - 1) return h(x, z);
+        bool oddX = x & 1, oddZ = z & 1;
+        if (oddX && oddZ) return (h(x + 1, z - 1) + h(x - 1, z + 1)) * 0.5f;
+        if (oddX) return (h(x - 1, z) + h(x + 1, z)) * 0.5f;
+        if (oddZ) return (h(x, z - 1) + h(x, z + 1)) * 0.5f;
+        return h(x, z);
+    };
+
+    float* v = mesh.vertices;
+    for (int z = 0; z < side; z++) {
+        for (int x = 0; x < side; x++) {
+            *v++ = h(x, z);
+            *v++ = morphHeight(x, z);
+        }
+    }
+    const float skirtDepth = SKIRT_DEPTH * l.step;
+    for (int k = 0; k < 4 * l.tiles; k++) {
+        int x, z;
+        skirtGridPos(k, l.tiles, x, z);
+        *v++ = h(x, z) - skirtDepth;
+        *v++ = morphHeight(x, z) - skirtDepth;
+    }
+
+    mesh.minHeight = *std::min_element(heights, heights + gridVerts) - skirtDepth;
+    mesh.maxHeight = *std::max_element(heights, heights + gridVerts);
+}
+
+void ChunkWorkerPool::start(int threadCount) {
+    stopping = false;
+    freeRecords.clear();
+    for (int i = CHUNK_MESH_RECORDS - 1; i >= 0; i--) freeRecords.push_back(i);
+    pending.reserve((2 * CHUNK_KEEP_RADIUS + 1) * (2 * CHUNK_KEEP_RADIUS + 1));
+    finished.reserve(CHUNK_MESH_RECORDS);
+    for (int i = 0; i < threadCount; i++) {
+        workers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+void ChunkWorkerPool::stop() {
+    {
+        // Both locks: workers test it under either
+        std::scoped_lock lock(jobMutex, doneMutex);
+        stopping = true;
+        pending.clear();
+    }
+    jobReady.notify_all();
+    recordFree.notify_all();
+    for (auto& t : workers) t.join();
+    workers.clear();
+}
+
+void ChunkWorkerPool::request(int x, int z) {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        pending.push_back({x, z});
+    }
+    jobReady.notify_one();
+}
+
+void ChunkWorkerPool::setFocus(const glm::vec3& pos, float heading, int chunkX, int chunkZ, int radius) {
+    std::lock_guard<std::mutex> lock(jobMutex);
+    focusPos = pos;
+    focusDir = glm::vec2(std::sin(heading), std::cos(heading));
+    focusChunkX = chunkX;
+    focusChunkZ = chunkZ;
+    keepRadius = radius;
+
+    // Cancel jobs that drifted out of range before a worker picked them up
+    pending.erase(std::remove_if(pending.begin(), pending.end(),
+        [&](const std::pair<int, int>& key) {
+            return abs(key.first - chunkX) > radius || abs(key.second - chunkZ) > radius;
+        }), pending.end());
+}
+
+// Lower is sooner: distance to the car, discounted for chunks ahead of it
+float ChunkWorkerPool::priority(const std::pair<int, int>& key) const {
+    const float chunkWorld = CHUNK_SIZE * TILE_SIZE;
+    glm::vec2 center((key.first + 0.5f) * chunkWorld, (key.second + 0.5f) * chunkWorld);
+    glm::vec2 toChunk = center - glm::vec2(focusPos.x, focusPos.z);
+    float dist = glm::length(toChunk);
+    if (dist < 1e-3f) return 0.0f;
+
+    float facing = glm::dot(toChunk / dist, focusDir);
+    return dist * (1.0f - 0.5f * std::max(facing, 0.0f));
+}
+
+void ChunkWorkerPool::workerLoop() {
+    LinearArena scratch(CHUNK_SCRATCH_BYTES);
+    for (;;) {
+        // Hold a record before taking a job, so uploads throttle meshing
+        int record;
+        {
+            std::unique_lock<std::mutex> lock(doneMutex);
+            recordFree.wait(lock, [this] { return stopping || !freeRecords.empty(); });
+            if (stopping) return;
+            record = freeRecords.back();
+            freeRecords.pop_back();
+        }
+
+        std::pair<int, int> key;
+        int lod;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobReady.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (stopping) return;
+
+            auto best = std::min_element(pending.begin(), pending.end(),
+                [this](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+                    return priority(a) < priority(b);
+                });
+            key = *best;
+            *best = pending.back();
+            pending.pop_back();
+            lod = chunkLodForRing(std::max(abs(key.first - focusChunkX), abs(key.second - focusChunkZ)));
+        }
+
+        auto buildStart = std::chrono::steady_clock::now();
+        buildChunkMesh(key.first, key.second, lod, records[record], scratch);
+        buildNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - buildStart).count();
+        chunksBuilt++;
+
+        std::lock_guard<std::mutex> lock(doneMutex);
+        finished.push_back(record);
+    }
+}
+
+void ChunkWorkerPool::collectFinished(std::vector<int>& out) {
+    std::lock_guard<std::mutex> lock(doneMutex);
+    out.insert(out.end(), finished.begin(), finished.end());
+    finished.clear();
+}
+
+void ChunkWorkerPool::releaseRecords(const int* ids, size_t count) {
+    if (count == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(doneMutex);
+        freeRecords.insert(freeRecords.end(), ids, ids + count);
+    }
+    recordFree.notify_all();
+}
@@ -0,0 +1,70 @@
+#pragma once
+// Vertex/index data is built on background threads; the GL thread only
+// uploads finished meshes, a few per frame, within CHUNK_UPLOAD_BUDGET_MS.
+
+#include "memory.h"
+#include "terrain.h"
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+const int MAX_CHUNK_VERTICES = FULL_GRID_VERTS + 4 * CHUNK_SIZE;     // LOD 0 grid + skirt
+
+// Fixed-size, so records are recycled between workers and the GL thread
+// instead of allocating two vectors per chunk
+struct ChunkMesh {
+    int x, z;
+    int lod;
+    int vertexCount;
+    float vertices[MAX_CHUNK_VERTICES * 2];     // (height, morph height) per vertex, grid row-major in z, then skirt
+    float heights[FULL_GRID_VERTS];             // the LOD's grid; LOD 0 feeds the gameplay heightfield
+    float minHeight, maxHeight;
+};
+
+const int CHUNK_MESH_RECORDS = 128;     // built-but-not-uploaded meshes in flight; workers wait when all are out
+
+// Per-worker scratch for one buildChunkMesh(): a full-resolution height
+// grid and the batch sample coordinates, each with alignment slack
+const size_t CHUNK_SCRATCH_BYTES = 3 * (FULL_GRID_VERTS * sizeof(float) + alignof(std::max_align_t));
+
+void buildChunkMesh(int chunkX, int chunkZ, int lod, ChunkMesh& mesh, LinearArena& scratch);
+
+struct ChunkWorkerPool {
+    std::vector<std::thread> workers;
+
+    std::mutex jobMutex;
+    std::condition_variable jobReady;
+    std::vector<std::pair<int, int>> pending;   // requested, not yet picked up
+    glm::vec3 focusPos = glm::vec3(0.0f);
+    glm::vec2 focusDir = glm::vec2(0.0f, 1.0f);
+    int focusChunkX = 0, focusChunkZ = 0;       // LOD is picked from this when a job starts
+    int keepRadius = CHUNK_KEEP_RADIUS;
+    bool stopping = false;
+
+    std::mutex doneMutex;
+    std::condition_variable recordFree;
+    ChunkMesh records[CHUNK_MESH_RECORDS];
+    std::vector<int> freeRecords;
+    std::vector<int> finished;                  // records built, waiting for upload
+
+    std::atomic<long long> buildNanos{0};       // worker CPU time spent meshing
+    std::atomic<int> chunksBuilt{0};
+
+    void start(int threadCount);
+    void stop();
+    void request(int x, int z);
+    void setFocus(const glm::vec3& pos, float heading, int chunkX, int chunkZ, int radius);
+    void collectFinished(std::vector<int>& out);
+    void releaseRecords(const int* ids, size_t count);
+
+    float priority(const std::pair<int, int>& key) const;
+    void workerLoop();
+};
+
+extern ChunkWorkerPool chunkWorkers;
@@ -0,0 +1,92 @@
+#include "entity_pool.h"
+
+// Widest instruction set the compiler targets; the bullet loop is memory
+// bound, so unlike the terrain sampler it has no runtime dispatch.
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define ENTITY_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define ENTITY_SIMD_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #include <arm_neon.h>
+    #define ENTITY_SIMD_NEON
+#endif
+
+int integrateBullets(BulletPool& pool, size_t begin, size_t end, float dt, glm::vec3 target) {
+    float* x = pool[BULLET_X];
+    float* y = pool[BULLET_Y];
+    float* z = pool[BULLET_Z];
+    const float* vx = pool[BULLET_VX];
+    const float* vy = pool[BULLET_VY];
+    const float* vz = pool[BULLET_VZ];
+    float* life = pool[BULLET_LIFETIME];
+    const float hitRadius2 = BULLET_HIT_RADIUS * BULLET_HIT_RADIUS;
+    size_t n = end, i = begin;
+    int hits = 0;
+
+#if defined(ENTITY_SIMD_AVX2)
+    __m256 vdt = _mm256_set1_ps(dt), r2 = _mm256_set1_ps(hitRadius2);
+    __m256 tx = _mm256_set1_ps(target.x), ty = _mm256_set1_ps(target.y), tz = _mm256_set1_ps(target.z);
+    for (; i + 8 <= n; i += 8) {
+        __m256 px = _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_mul_ps(_mm256_loadu_ps(vx + i), vdt));
+        __m256 py = _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(_mm256_loadu_ps(vy + i), vdt));
+        __m256 pz = _mm256_add_ps(_mm256_loadu_ps(z + i), _mm256_mul_ps(_mm256_loadu_ps(vz + i), vdt));
+        __m256 dx = _mm256_sub_ps(px, tx), dy = _mm256_sub_ps(py, ty), dz = _mm256_sub_ps(pz, tz);
+        __m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+        __m256 hit = _mm256_cmp_ps(d2, r2, _CMP_LT_OQ);
+        __m256 l = _mm256_sub_ps(_mm256_loadu_ps(life + i), vdt);
+        _mm256_storeu_ps(x + i, px);
+        _mm256_storeu_ps(y + i, py);
+        _mm256_storeu_ps(z + i, pz);
+        _mm256_storeu_ps(life + i, _mm256_andnot_ps(hit, l));
+        for (int m = _mm256_movemask_ps(hit); m; m &= m - 1) hits++;
+    }
+#elif defined(ENTITY_SIMD_SSE2)
+    __m128 vdt = _mm_set1_ps(dt), r2 = _mm_set1_ps(hitRadius2);
+    __m128 tx = _mm_set1_ps(target.x), ty = _mm_set1_ps(target.y), tz = _mm_set1_ps(target.z);
+    for (; i + 4 <= n; i += 4) {
+        __m128 px = _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(_mm_loadu_ps(vx + i), vdt));
+        __m128 py = _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(_mm_loadu_ps(vy + i), vdt));
+        __m128 pz = _mm_add_ps(_mm_loadu_ps(z + i), _mm_mul_ps(_mm_loadu_ps(vz + i), vdt));
+        __m128 dx = _mm_sub_ps(px, tx), dy = _mm_sub_ps(py, ty), dz = _mm_sub_ps(pz, tz);
+        __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        __m128 hit = _mm_cmplt_ps(d2, r2);
+        __m128 l = _mm_sub_ps(_mm_loadu_ps(life + i), vdt);
+        _mm_storeu_ps(x + i, px);
+        _mm_storeu_ps(y + i, py);
+        _mm_storeu_ps(z + i, pz);
+        _mm_storeu_ps(life + i, _mm_andnot_ps(hit, l));
+        for (int m = _mm_movemask_ps(hit); m; m &= m - 1) hits++;
+    }
+#elif defined(ENTITY_SIMD_NEON)
+    float32x4_t vdt = vdupq_n_f32(dt), r2 = vdupq_n_f32(hitRadius2);
+    float32x4_t tx = vdupq_n_f32(target.x), ty = vdupq_n_f32(target.y), tz = vdupq_n_f32(target.z);
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t px = vaddq_f32(vld1q_f32(x + i), vmulq_f32(vld1q_f32(vx + i), vdt));
+        float32x4_t py = vaddq_f32(vld1q_f32(y + i), vmulq_f32(vld1q_f32(vy + i), vdt));
+        float32x4_t pz = vaddq_f32(vld1q_f32(z + i), vmulq_f32(vld1q_f32(vz + i), vdt));
+        float32x4_t dx = vsubq_f32(px, tx), dy = vsubq_f32(py, ty), dz = vsubq_f32(pz, tz);
+        float32x4_t d2 = vaddq_f32(vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy)), vmulq_f32(dz, dz));
+        uint32x4_t hit = vcltq_f32(d2, r2);
+        float32x4_t l = vsubq_f32(vld1q_f32(life + i), vdt);
+        vst1q_f32(x + i, px);
+        vst1q_f32(y + i, py);
+        vst1q_f32(z + i, pz);
+        vst1q_f32(life + i, vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(l), hit)));
+        hits += (int)vaddvq_u32(vshrq_n_u32(hit, 31));
+    }
+#endif
+    for (; i < n; i++) {
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        z[i] += vz[i] * dt;
+        life[i] -= dt;
+        float dx = x[i] - target.x, dy = y[i] - target.y, dz = z[i] - target.z;
+        if (dx * dx + dy * dy + dz * dz < hitRadius2) {
+            life[i] = 0;
+            hits++;
+        }
+    }
+    return hits;
+}
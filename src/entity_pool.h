@@ -0,0 +1,81 @@
+#pragma once
+// Cops and bullets are stored structure-of-arrays: one contiguous float
+// column per component, indexed by entity, so each system streams through
+// only the columns it touches. Removal swaps the last entity into the
+// hole; order is not stable and indices are only good for the current tick.
+// Capacity is fixed and reserved up front, so spawning never reallocates.
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+
+template <int N, size_t CAPACITY>
+struct ComponentPool {
+    std::vector<float> columns[N];
+    int rejected = 0;       // add() calls refused at capacity
+
+    ComponentPool() {
+        for (auto& col : columns) col.reserve(CAPACITY);
+    }
+
+    size_t size() const { return columns[0].size(); }
+    bool empty() const { return columns[0].empty(); }
+    bool full() const { return size() >= CAPACITY; }
+    float* operator[](int c) { return columns[c].data(); }
+    const float* operator[](int c) const { return columns[c].data(); }
+
+    size_t add() {
+        for (auto& col : columns) col.push_back(0.0f);
+        return size() - 1;
+    }
+
+    void swapRemove(size_t i) {
+        for (auto& col : columns) {
+            col[i] = col.back();
+            col.pop_back();
+        }
+    }
+
+    void clear() {
+        for (auto& col : columns) col.clear();
+    }
+
+    // Components c, c+1, c+2 of entity i as a vector
+    glm::vec3 vec3(int c, size_t i) const {
+        return glm::vec3(columns[c][i], columns[c + 1][i], columns[c + 2][i]);
+    }
+
+    void setVec3(int c, size_t i, glm::vec3 v) {
+        columns[c][i] = v.x;
+        columns[c + 1][i] = v.y;
+        columns[c + 2][i] = v.z;
+    }
+};
+
+enum BulletComponent {
+    BULLET_X, BULLET_Y, BULLET_Z,
+    BULLET_VX, BULLET_VY, BULLET_VZ,
+    BULLET_PREV_X, BULLET_PREV_Y, BULLET_PREV_Z,    // position at the start of the last sim tick
+    BULLET_LIFETIME,
+    BULLET_COMPONENTS
+};
+
+enum CopComponent {
+    COP_X, COP_Y, COP_Z,
+    COP_ROTATION, COP_SPEED,
+    COP_PREV_X, COP_PREV_Y, COP_PREV_Z,
+    COP_PREV_ROTATION,
+    COP_COMPONENTS
+};
+
+const size_t MAX_BULLETS = 65536;
+const size_t MAX_COPS = 4096;
+
+using BulletPool = ComponentPool<BULLET_COMPONENTS, MAX_BULLETS>;
+using CopPool = ComponentPool<COP_COMPONENTS, MAX_COPS>;
+
+const float BULLET_HIT_RADIUS = 2.0f;
+
+// Moves bullets [begin, end) by dt, ages them, and zeroes the lifetime of
+// any that ended within BULLET_HIT_RADIUS of target. Returns the number of hits.
+int integrateBullets(BulletPool& pool, size_t begin, size_t end, float dt, glm::vec3 target);
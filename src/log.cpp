@@ -0,0 +1,83 @@
+#include "log.h"
+
+#include <cstdarg>
+#include <cstdio>
+
+Logger logger;
+
+void Logger::push(LogLevel level, const char* text) {
+    uint64_t index = writeIndex.load(std::memory_order_relaxed);
+    LogSlot* slot;
+    while (true) {
+        slot = &slots[index & (CAPACITY - 1)];
+        uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+        if (sequence == index) {
+            if (writeIndex.compare_exchange_weak(index, index + 1, std::memory_order_relaxed)) break;
+        } else if (sequence < index) {
+            dropped.fetch_add(1, std::memory_order_relaxed);    // full: the drain thread is a lap behind
+            return;
+        } else {
+            index = writeIndex.load(std::memory_order_relaxed);
+        }
+    }
+    slot->level = level;
+    snprintf(slot->text, sizeof(slot->text), "%s", text);
+    slot->sequence.store(index + 1, std::memory_order_release);
+}
+
+bool Logger::drain() {
+    bool any = false;
+    uint64_t index = readIndex.load(std::memory_order_relaxed);
+    while (true) {
+        LogSlot& slot = slots[index & (CAPACITY - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != index + 1) break;
+        FILE* out = slot.level == LOG_LEVEL_ERROR ? stderr : stdout;
+        fputs(slot.text, out);
+        fputc('\n', out);
+        slot.sequence.store(index + CAPACITY, std::memory_order_release);
+        readIndex.store(++index, std::memory_order_release);
+        any = true;
+    }
+    if (uint32_t lost = dropped.exchange(0, std::memory_order_relaxed)) {
+        fprintf(stdout, "(log: %u messages dropped)\n", lost);
+        any = true;
+    }
+    if (any) fflush(stdout);
+    return any;
+}
+
+void Logger::start() {
+    stopping = false;
+    drainThread = std::thread([this] {
+        while (!stopping.load(std::memory_order_acquire)) {
+            if (!drain()) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        drain();
+    });
+}
+
+void Logger::stop() {
+    if (!drainThread.joinable()) return;
+    stopping = true;
+    drainThread.join();
+}
+
+void Logger::flush() {
+    uint64_t target = writeIndex.load(std::memory_order_acquire);
+    while (drainThread.joinable() && readIndex.load(std::memory_order_acquire) < target) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// printf-style; `suppressed` is appended when a rate-limited site skipped messages
+void logMessage(LogLevel level, uint32_t suppressed, const char* format, ...) {
+    char text[sizeof(LogSlot::text)];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    if (suppressed > 0 && length >= 0 && (size_t)length < sizeof(text)) {
+        snprintf(text + length, sizeof(text) - length, " (+%u suppressed)", suppressed);
+    }
+    logger.push(level, text);
+}
@@ -0,0 +1,85 @@
+#pragma once
+// logMessage() formats into a ring slot and returns; a background thread
+// writes the text out, so the game loop never waits on console I/O.
+// Producers claim a slot with one CAS and publish it through its sequence
+// number (bounded MPSC queue); when the ring is full the message is dropped
+// and counted instead. LOG_EVERY caps a call site at one message per
+// interval and notes how many it swallowed. Building with GTA7_DEBUG_LOG=0
+// compiles every LOG_DEBUG site out.
+
+#include "profiler.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#ifndef GTA7_DEBUG_LOG
+    #define GTA7_DEBUG_LOG 1
+#endif
+
+enum LogLevel { LOG_LEVEL_DEBUG, LOG_LEVEL_INFO, LOG_LEVEL_WARN, LOG_LEVEL_ERROR };
+
+struct LogSlot {
+    std::atomic<uint64_t> sequence{0};  // index when free, index+1 once written
+    LogLevel level;
+    char text[240];
+};
+
+struct Logger {
+    static const uint64_t CAPACITY = 1024;
+    LogSlot slots[CAPACITY];
+    std::atomic<uint64_t> writeIndex{0};
+    std::atomic<uint64_t> readIndex{0};
+    std::atomic<uint32_t> dropped{0};
+    std::atomic<bool> stopping{false};
+    std::thread drainThread;
+
+    Logger() {
+        for (uint64_t i = 0; i < CAPACITY; i++) slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    void start();
+    void stop();
+    void flush();                       // blocks until everything queued so far is written
+    void push(LogLevel level, const char* text);
+    bool drain();                       // drain thread only; false if nothing was ready
+};
+
+extern Logger logger;
+
+// printf-style; `suppressed` is appended when a rate-limited site skipped messages
+void logMessage(LogLevel level, uint32_t suppressed, const char* format, ...);
+
+// Per-call-site rate limit for LOG_EVERY
+struct LogSite {
+    std::atomic<uint64_t> nextNs{0};
+    std::atomic<uint32_t> suppressed{0};
+
+    // True if the site may log now; `skipped` gets the count swallowed since its last message
+    bool allow(uint64_t intervalNs, uint32_t& skipped) {
+        uint64_t now = profiler.nowNs();
+        uint64_t next = nextNs.load(std::memory_order_relaxed);
+        if (now < next || !nextNs.compare_exchange_strong(next, now + intervalNs, std::memory_order_relaxed)) {
+            suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        skipped = suppressed.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+};
+
+#define LOG_INFO(...) logMessage(LOG_LEVEL_INFO, 0, __VA_ARGS__)
+#define LOG_WARN(...) logMessage(LOG_LEVEL_WARN, 0, __VA_ARGS__)
+#define LOG_ERROR(...) logMessage(LOG_LEVEL_ERROR, 0, __VA_ARGS__)
+#define LOG_EVERY(level, intervalMs, ...) do { \
+        static LogSite logSite_; \
+        uint32_t logSkipped_; \
+        if (logSite_.allow((uint64_t)((intervalMs) * 1000000.0), logSkipped_)) \
+            logMessage(level, logSkipped_, __VA_ARGS__); \
+    } while (0)
+#if GTA7_DEBUG_LOG
+    #define LOG_DEBUG_EVERY(intervalMs, ...) LOG_EVERY(LOG_LEVEL_DEBUG, intervalMs, __VA_ARGS__)
+#else
+    // Arguments stay type-checked but the call is dead code
+    #define LOG_DEBUG_EVERY(intervalMs, ...) do { if (false) logMessage(LOG_LEVEL_DEBUG, 0, __VA_ARGS__); } while (0)
+#endif
@@ -0,0 +1,59 @@
+#include "memory.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+// Kept out of line: GCC flags new/free pairs once the replacement inlines
+#if defined(__GNUC__)
+    #define NOINLINE_ALLOC __attribute__((noinline))
+#elif defined(_MSC_VER)
+    #define NOINLINE_ALLOC __declspec(noinline)
+#else
+    #define NOINLINE_ALLOC
+#endif
+
+std::atomic<uint64_t> heapAllocations{0};
+thread_local uint64_t threadHeapAllocations = 0;
+
+NOINLINE_ALLOC void* operator new(std::size_t bytes) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    threadHeapAllocations++;
+    if (void* p = std::malloc(bytes ? bytes : 1)) return p;
+    throw std::bad_alloc();
+}
+
+NOINLINE_ALLOC void operator delete(void* p) noexcept { std::free(p); }
+NOINLINE_ALLOC void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+void* LinearArena::alloc(size_t bytes, size_t align) {
+    size_t start = (used + align - 1) & ~(align - 1);
+    if (start + bytes > capacity) {
+        overflows++;
+        overflowBlocks.push_back(std::malloc(bytes ? bytes : 1));
+        return overflowBlocks.back();
+    }
+    used = start + bytes;
+    peak = std::max(peak, used);
+    return base + start;
+}
+
+void LinearArena::reset() {
+    for (void* p : overflowBlocks) std::free(p);
+    overflowBlocks.clear();
+    used = 0;
+}
+
+LinearArena frameArena(FRAME_ARENA_BYTES);
+
+FrameMemoryStats frameMemory;
+
+void endFrameMemory() {
+    uint64_t total = heapAllocations.load(std::memory_order_relaxed);
+    frameMemory.mainAllocs = threadHeapAllocations - frameMemory.mainAtFrameStart;
+    frameMemory.totalAllocs = total - frameMemory.totalAtFrameStart;
+    frameMemory.mainAtFrameStart = threadHeapAllocations;
+    frameMemory.totalAtFrameStart = total;
+    frameMemory.arenaUsed = frameArena.used;
+    frameArena.reset();
+}
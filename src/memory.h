@@ -0,0 +1,57 @@
+#pragma once
+// Steady-state frames should not touch the heap. Per-frame scratch comes
+// from frameArena, which is rewound at the buffer swap; chunk meshing uses
+// per-worker arenas and recycled mesh records, and the entity pools are
+// reserved up front. The replaced global operator new counts what slips
+// through, per thread and in total, for the perf overlay and benchmarks.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+extern std::atomic<uint64_t> heapAllocations;
+extern thread_local uint64_t threadHeapAllocations;
+
+// Bump allocator over one block. reset() frees everything at once; when a
+// request does not fit it falls back to the heap until the next reset and
+// counts the overflow, so the capacity can be raised.
+struct LinearArena {
+    char* base;
+    size_t capacity;
+    size_t used = 0;
+    size_t peak = 0;
+    int overflows = 0;
+    std::vector<void*> overflowBlocks;
+
+    explicit LinearArena(size_t bytes) : base(static_cast<char*>(std::malloc(bytes))), capacity(bytes) {}
+    ~LinearArena() { reset(); std::free(base); }
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+
+    void* alloc(size_t bytes, size_t align);
+    void reset();
+
+    template <typename T>
+    T* allocArray(size_t count) { return static_cast<T*>(alloc(count * sizeof(T), alignof(T))); }
+};
+
+const size_t FRAME_ARENA_BYTES = 1 << 20;
+
+// Main thread only; valid until the end of the frame
+extern LinearArena frameArena;
+
+// Last completed frame, for the overlay and benchmark report
+struct FrameMemoryStats {
+    uint64_t mainAllocs = 0;        // heap allocations on the main thread
+    uint64_t totalAllocs = 0;       // on every thread, chunk and audio workers included
+    size_t arenaUsed = 0;
+    uint64_t mainAtFrameStart = 0;
+    uint64_t totalAtFrameStart = 0;
+};
+
+extern FrameMemoryStats frameMemory;
+
+// Called at the buffer swap (or where it would be, headless)
+void endFrameMemory();
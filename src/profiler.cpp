@@ -0,0 +1,33 @@
+#include "profiler.h"
+
+#include <cstdio>
+
+Profiler profiler;
+
+// Chrome trace format (chrome://tracing, Perfetto): one complete event per zone
+bool Profiler::writeChromeTrace(const char* path) const {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+
+    uint64_t end = writeIndex.load(std::memory_order_acquire);
+    uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+    fprintf(f, "{\"traceEvents\":[\n");
+    bool first = true;
+    for (uint64_t i = begin; i < end; i++) {
+        const char* name;
+        uint32_t thread;
+        uint64_t startNs, endNs;
+        if (!read(i, name, thread, startNs, endNs)) continue;
+        fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                first ? "" : ",\n", name, thread, startNs / 1000.0, (endNs - startNs) / 1000.0);
+        first = false;
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    return true;
+}
+
+double nowMs() {
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,117 @@
+#pragma once
+// PROFILE_ZONE("name") times the enclosing scope and writes it into a
+// fixed ring of events. Any thread may record; a slot is claimed with one
+// atomic increment and published through its sequence number, so writers
+// never lock and readers skip slots that are mid-write or overwritten.
+// Zone names must be string literals; they are compared by pointer.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Seqlock slot: the payload is relaxed atomics so a reader racing a writer
+// sees torn values, never undefined behaviour, and rejects them on the
+// sequence re-check
+struct ProfileEvent {
+    std::atomic<uint64_t> sequence{0};  // 2*index+2 once the slot is complete
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint32_t> thread{0};
+    std::atomic<uint64_t> startNs{0}, endNs{0};
+};
+
+struct Profiler {
+    static const uint64_t CAPACITY = 1 << 15;
+    ProfileEvent events[CAPACITY];
+    std::atomic<uint64_t> writeIndex{0};
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    uint64_t nowNs() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    static uint32_t threadIndex() {
+        static std::atomic<uint32_t> nextThread{0};
+        thread_local uint32_t index = nextThread++;
+        return index;
+    }
+
+    void record(const char* name, uint64_t startNs, uint64_t endNs) {
+        uint64_t index = writeIndex.fetch_add(1, std::memory_order_relaxed);
+        ProfileEvent& e = events[index & (CAPACITY - 1)];
+        e.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);    // odd sequence visible before any field
+        e.name.store(name, std::memory_order_relaxed);
+        e.thread.store(threadIndex(), std::memory_order_relaxed);
+        e.startNs.store(startNs, std::memory_order_relaxed);
+        e.endNs.store(endNs, std::memory_order_relaxed);
+        e.sequence.store(2 * index + 2, std::memory_order_release);
+    }
+
+    // Copies event `index` out if it is complete and not yet overwritten
+    bool read(uint64_t index, const char*& name, uint32_t& thread, uint64_t& startNs, uint64_t& endNs) const {
+        const ProfileEvent& e = events[index & (CAPACITY - 1)];
+        if (e.sequence.load(std::memory_order_acquire) != 2 * index + 2) return false;
+        name = e.name.load(std::memory_order_relaxed);
+        thread = e.thread.load(std::memory_order_relaxed);
+        startNs = e.startNs.load(std::memory_order_relaxed);
+        endNs = e.endNs.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return e.sequence.load(std::memory_order_relaxed) == 2 * index + 2;
+    }
+
+    bool writeChromeTrace(const char* path) const;
+};
+
+extern Profiler profiler;
+
+struct ScopedZone {
+    const char* name;
+    uint64_t startNs;
+    explicit ScopedZone(const char* n) : name(n), startNs(profiler.nowNs()) {}
+    ~ScopedZone() { profiler.record(name, startNs, profiler.nowNs()); }
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) ScopedZone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+
+// Per-zone milliseconds per frame, smoothed, for the overlay
+struct ZoneStats {
+    static const int MAX_ZONES = 32;
+    const char* names[MAX_ZONES] = {};
+    double frameMs[MAX_ZONES] = {};     // accumulated this frame
+    double smoothMs[MAX_ZONES] = {};
+    int count = 0;
+    uint64_t readIndex = 0;
+
+    // Folds every event recorded since the last call into this frame's totals
+    void collect(const Profiler& p) {
+        uint64_t end = p.writeIndex.load(std::memory_order_acquire);
+        if (end - readIndex > Profiler::CAPACITY) readIndex = end - Profiler::CAPACITY;
+        for (; readIndex < end; readIndex++) {
+            const char* name;
+            uint32_t thread;
+            uint64_t startNs, endNs;
+            if (!p.read(readIndex, name, thread, startNs, endNs)) continue;
+
+            int slot = 0;
+            while (slot < count && names[slot] != name) slot++;
+            if (slot == count) {
+                if (count == MAX_ZONES) continue;
+                names[count++] = name;
+            }
+            frameMs[slot] += (endNs - startNs) / 1e6;
+        }
+    }
+
+    void endFrame() {
+        for (int i = 0; i < count; i++) {
+            smoothMs[i] += (frameMs[i] - smoothMs[i]) * 0.1;
+            frameMs[i] = 0;
+        }
+    }
+};
+
+// Milliseconds on the steady clock
+double nowMs();
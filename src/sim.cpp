@@ -0,0 +1,543 @@
+#include "sim.h"
+
+#include "log.h"
+#include "memory.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifndef M_PI
+    #define M_PI 3.14159265358979323846
+#endif
+
+std::vector<Building> buildings;
+int buildingGeneration = 0;
+SpatialGrid buildingGrid;
+
+// Random generator
+std::random_device rd;
+std::mt19937 gen(rd());
+
+SoundEvent soundEvents[SOUND_EVENT_CAPACITY];
+int soundEventCount = 0;
+
+void playSound(AudioClip clip, const glm::vec3& position) {
+    if (soundEventCount < SOUND_EVENT_CAPACITY) soundEvents[soundEventCount++] = {clip, position};
+}
+
+ParticleBurst particleBursts[PARTICLE_BURST_CAPACITY];
+int particleBurstCount = 0;
+
+void emitParticles(ParticleEffect effect, const glm::vec3& position, const glm::vec3& direction) {
+    if (particleBurstCount < PARTICLE_BURST_CAPACITY) particleBursts[particleBurstCount++] = {effect, position, direction};
+}
+
+// Building footprint expanded by the car's radius
+static inline void buildingCollisionBox(const Building& b, float& minX, float& minZ, float& maxX, float& maxZ) {
+    minX = b.position.x - b.width/2 - CAR_COLLISION_RADIUS;
+    maxX = b.position.x + b.width/2 + CAR_COLLISION_RADIUS;
+    minZ = b.position.z - b.depth/2 - CAR_COLLISION_RADIUS;
+    maxZ = b.position.z + b.depth/2 + CAR_COLLISION_RADIUS;
+}
+
+const Building* findBuildingCollision(float x, float z) {
+    const std::vector<int>* nearby = buildingGrid.query(x, z);
+    if (!nearby) return nullptr;
+
+    for (int i : *nearby) {
+        const Building& b = buildings[i];
+        float minX, minZ, maxX, maxZ;
+        buildingCollisionBox(b, minX, minZ, maxX, maxZ);
+        if (x >= minX && x <= maxX && z >= minZ && z <= maxZ) return &b;
+    }
+    return nullptr;
+}
+
+void spawnBuildings(int count) {
+    buildings.clear();
+    buildingGrid.clear();
+    buildingGeneration++;
+    std::uniform_real_distribution<> x(-50, 50);
+    std::uniform_real_distribution<> z(-50, 50);
+    for (int i = 0; i < count; i++) {
+        Building b;
+        b.position = glm::vec3(x(gen), 0, z(gen));
+        b.width = 8.0f;
+        b.depth = 8.0f;
+        b.height = 12.0f;
+        b.position.y = getTerrainInfo(b.position.x, b.position.z).height;
+
+        float minX, minZ, maxX, maxZ;
+        buildingCollisionBox(b, minX, minZ, maxX, maxZ);
+        buildingGrid.insert((int)buildings.size(), minX, minZ, maxX, maxZ);
+        buildings.push_back(b);
+    }
+}
+
+void spawnPuddles(int count) {
+    puddles.clear();
+    puddleGrid.clear();
+    std::uniform_real_distribution<> dist(-100, 100);
+    std::uniform_real_distribution<> rad(3, 8);
+    for (int i = 0; i < count; i++) {
+        Puddle p;
+        p.pos = glm::vec2(dist(gen), dist(gen));
+        p.radius = rad(gen);
+        puddleGrid.insert((int)puddles.size(), p.pos.x - p.radius, p.pos.y - p.radius,
+                          p.pos.x + p.radius, p.pos.y + p.radius);
+        puddles.push_back(p);
+    }
+    rebuildResidentTileTypes();
+}
+
+Car car;
+CopPool policeCars;
+BulletPool bullets;
+
+void Car::update(float dt, bool forward, bool backward, bool left, bool right, bool drift) {
+    const float accel = 18.0f;
+    const float brake = 25.0f;
+    const float maxSpeed = 25.0f;
+    const float friction = 4.0f;
+    
+    TerrainInfo info = getTerrainInfo(position.x, position.z);
+    position.y = info.height + 0.5f;
+
+    float speedMult = 1.0f;
+    float steerMult = 1.0f;
+
+    switch (info.type) {
+        case TERRAIN_ROAD:
+            speedMult = 1.5f;   // 50% faster
+            steerMult = 1.2f;
+            break;
+        case TERRAIN_GRASS:
+            speedMult = 0.5f;   // 50% speed - you'll feel this
+            steerMult = 0.7f;
+            break;
+        case TERRAIN_DIRT:
+            speedMult = 0.3f;   // 30% speed - very slow
+            steerMult = 0.5f;
+            break;
+        case TERRAIN_PUDDLE:
+            speedMult = 0.1f;   // 10% speed - almost stuck
+            steerMult = 0.15f;  // barely steerable
+            drift = true;
+            break;
+    }
+
+    static float debugTimer = 0.0f;
+    static TerrainType lastType = TERRAIN_ROAD;
+    debugTimer += dt;
+
+    if (info.type != lastType || debugTimer > 1.0f) {
+        const char* terrainName[] = {"ROAD", "GRASS", "DIRT", "PUDDLE"};
+        LOG_DEBUG_EVERY(100, "Terrain: %s | Speed Mult: %g | Current Speed: %g",
+                        terrainName[info.type], speedMult, speed);
+        lastType = info.type;
+        debugTimer = 0.0f;
+    }
+
+    isDrifting = drift;  // Set drift state
+    const float steerSpeed = (drift ? 3.5f : 2.2f) * steerMult;
+
+    if (forward) speed += accel * speedMult * dt;
+    if (backward) speed -= brake * speedMult * dt;
+
+    // Apply terrain-based friction (always, not just when coasting)
+    float terrainFriction = friction * (2.0f - speedMult); 
+
+    if (!forward && !backward) {
+        if (speed > 0) speed -= terrainFriction * dt;
+        if (speed < 0) speed += terrainFriction * dt;
+        if (std::fabs(speed) < 0.1f) speed = 0;
+    }
+
+    // CRITICAL FIX: Terrain-based max speed
+    float terrainMaxSpeed = maxSpeed * speedMult;
+    speed = glm::clamp(speed, -terrainMaxSpeed * 0.5f, terrainMaxSpeed);
+
+    // CRITICAL FIX: Active speed reduction when over terrain limit
+    if (speed > terrainMaxSpeed) {
+        speed -= (speed - terrainMaxSpeed) * 5.0f * dt; // Quick slowdown
+    }
+    if (speed < -terrainMaxSpeed * 0.5f) {
+        speed -= (speed + terrainMaxSpeed * 0.5f) * 5.0f * dt;
+    }
+
+
+
+    if (left) steerAngle = steerSpeed;
+    else if (right) steerAngle = -steerSpeed;
+    else steerAngle = 0;
+
+    if (std::fabs(speed) > 0.1f) {
+        float turnRate = isDrifting ? 0.7f : 1.0f;
+        rotation += steerAngle * dt * (speed / maxSpeed) * turnRate;
+    }
+
+    if (isDrifting) {
+        driftAngle += (steerAngle * 0.3f - driftAngle) * 5.0f * dt;
+    } else {
+        driftAngle *= 0.9f;
+    }
+
+    // Store old position
+    glm::vec3 oldPosition = position;
+
+    // Calculate new position
+    position.x += std::sin(rotation) * speed * dt;
+    position.z += std::cos(rotation) * speed * dt;
+
+    // === BUILDING COLLISION (with car size buffer) ===
+    const Building* hit = findBuildingCollision(position.x, position.z);
+    bool collided = hit != nullptr;
+
+    if (collided) {
+        // REVERT to old position completely
+        position = oldPosition;
+        
+        // Stop the car
+        speed *= 0.2f;
+        
+        LOG_DEBUG_EVERY(250, "BUMPED INTO BUILDING! (at %g, %g)", hit->position.x, hit->position.z);
+        if (std::fabs(speed) > 1.0f) {      // not while resting against the wall
+            playSound(CLIP_IMPACT, position);
+            emitParticles(EFFECT_SPARKS, position, glm::vec3(0.0f));
+        }
+    }
+
+    // If we collided, try to slide along the wall instead of full stop
+    if (collided) {
+        // Try moving only in X direction
+        glm::vec3 slideX = oldPosition;
+        slideX.x += std::sin(rotation) * speed * dt;
+        bool canSlideX = findBuildingCollision(slideX.x, slideX.z) == nullptr;
+        
+        // Try moving only in Z direction
+        glm::vec3 slideZ = oldPosition;
+        slideZ.z += std::cos(rotation) * speed * dt;
+        bool canSlideZ = findBuildingCollision(slideZ.x, slideZ.z) == nullptr;
+        
+        // Apply sliding if possible
+        if (canSlideX) position.x = slideX.x;
+        if (canSlideZ) position.z = slideZ.z;
+    }
+
+}
+
+FlowField flowField;
+
+void FlowField::update(const glm::vec3& target) {
+    int tx = cellOf(target.x), tz = cellOf(target.z);
+    if (!next.empty() && tx == targetCellX && tz == targetCellZ && builtForBuildings == buildingGeneration) return;
+    PROFILE_ZONE("flowField.rebuild");
+    targetCellX = tx;
+    targetCellZ = tz;
+    builtForBuildings = buildingGeneration;
+    originX = tx - FLOW_GRID_SIDE / 2;
+    originZ = tz - FLOW_GRID_SIDE / 2;
+    rebuilds++;
+
+    const int side = FLOW_GRID_SIDE;
+    blocked.assign(side * side, 0);
+    for (const Building& b : buildings) {
+        float minX, minZ, maxX, maxZ;
+        buildingCollisionBox(b, minX, minZ, maxX, maxZ);
+        // Cells whose centre is inside the box
+        int x0 = std::max((int)ceil(minX / FLOW_CELL_SIZE - 0.5f) - originX, 0);
+        int x1 = std::min((int)floor(maxX / FLOW_CELL_SIZE - 0.5f) - originX, side - 1);
+        int z0 = std::max((int)ceil(minZ / FLOW_CELL_SIZE - 0.5f) - originZ, 0);
+        int z1 = std::min((int)floor(maxZ / FLOW_CELL_SIZE - 0.5f) - originZ, side - 1);
+        for (int z = z0; z <= z1; z++) {
+            for (int x = x0; x <= x1; x++) blocked[z * side + x] = 1;
+        }
+    }
+
+    // Dijkstra outward from the player; each cell points back the way it was
+    // reached. Steps cost at most 3, so four rotating buckets replace a heap.
+    cost.assign(side * side, FLOW_UNREACHED);
+    next.assign(side * side, FLOW_NONE);
+    for (auto& bucket : buckets) bucket.clear();
+    int start = (side / 2) * side + side / 2;
+    cost[start] = 0;
+    buckets[0].push_back(start);
+    size_t queued = 1;
+    for (uint32_t c = 0; queued > 0; c++) {
+        std::vector<int>& bucket = buckets[c & 3];
+        for (int cell : bucket) {
+            if (cost[cell] != c) continue;          // reached cheaper since queued
+            int cx = cell % side, cz = cell / side;
+            for (int k = 0; k < 8; k++) {
+                int nx = cx + FLOW_DX[k], nz = cz + FLOW_DZ[k];
+                if (nx < 0 || nz < 0 || nx >= side || nz >= side) continue;
+                int n = nz * side + nx;
+                if (blocked[n]) continue;
+                // No cutting corners past a wall
+                if (k >= 4 && (blocked[cz * side + nx] || blocked[nz * side + cx])) continue;
+                uint32_t nc = c + FLOW_STEP_COST[k];
+                if (nc < cost[n]) {
+                    cost[n] = (uint16_t)nc;
+                    next[n] = FLOW_OPPOSITE[k];
+                    buckets[nc & 3].push_back(n);
+                    queued++;
+                }
+            }
+        }
+        queued -= bucket.size();
+        bucket.clear();
+    }
+}
+
+void updatePoliceCars(CopPool& cops, size_t begin, size_t end, float dt, glm::vec3 targetPos) {
+    float* px = cops[COP_X];
+    float* py = cops[COP_Y];
+    float* pz = cops[COP_Z];
+    float* rot = cops[COP_ROTATION];
+    float* spd = cops[COP_SPEED];
+
+    for (size_t i = begin; i < end; i++) {
+        glm::vec3 toTarget = targetPos - glm::vec3(px[i], py[i], pz[i]);
+        float dist = glm::length(toTarget);
+
+        if (dist > 1.0f) {
+            toTarget = toTarget / dist;
+
+            glm::vec2 flowDir;
+            float targetRot = flowField.direction(px[i], pz[i], flowDir)
+                ? atan2(flowDir.x, flowDir.y) : atan2(toTarget.x, toTarget.z);
+            float rotDiff = targetRot - rot[i];
+
+            while (rotDiff > M_PI) rotDiff -= 2 * M_PI;
+            while (rotDiff < -M_PI) rotDiff += 2 * M_PI;
+
+            rot[i] += rotDiff * 3.0f * dt;
+
+            float targetSpeed = dist > 30.0f ? 18.0f : 12.0f;
+            spd[i] += (targetSpeed - spd[i]) * 2.0f * dt;
+        }
+
+        px[i] += sin(rot[i]) * spd[i] * dt;
+        pz[i] += cos(rot[i]) * spd[i] * dt;
+        py[i] = sampleTerrainHeight(px[i], pz[i]) + 0.5f;
+    }
+}
+
+void spawnPoliceCar() {
+    std::uniform_real_distribution<> angle(0, 2 * M_PI);
+    float a = angle(gen);
+    float spawnDist = 60.0f;
+    glm::vec3 position = car.position + glm::vec3(cos(a) * spawnDist, 0, sin(a) * spawnDist);
+    position.y = sampleTerrainHeight(position.x, position.z) + 0.5f;
+
+    if (policeCars.full()) {
+        policeCars.rejected++;
+        return;
+    }
+    size_t cop = policeCars.add();      // rotation and speed start at 0
+    policeCars.setVec3(COP_X, cop, position);
+    policeCars.setVec3(COP_PREV_X, cop, position);
+}
+
+SimJobPool simJobs;
+
+void SimJobPool::start(int threadCount) {
+    for (int i = 0; i < threadCount; i++) workers.emplace_back([this] { workerLoop(); });
+}
+
+void SimJobPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : workers) t.join();
+    workers.clear();
+}
+
+void SimJobPool::drain() {
+    for (int j = nextJob++; j < jobCount; j = nextJob++) {
+        job(jobContext, j);
+        jobsDone++;
+    }
+}
+
+void SimJobPool::run(int count, void (*fn)(void*, int), void* context) {
+    if (workers.empty() || count <= 1) {
+        for (int j = 0; j < count; j++) fn(context, j);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = fn;
+        jobContext = context;
+        jobCount = count;
+        nextJob = 0;
+        jobsDone = 0;
+        generation++;
+    }
+    wake.notify_all();
+    drain();
+
+    // Wait for stragglers to leave drain() too, so none of them touches the next run
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return jobsDone == jobCount && activeWorkers == 0; });
+    job = nullptr;
+    jobContext = nullptr;
+}
+
+void SimJobPool::workerLoop() {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+        activeWorkers++;
+        lock.unlock();
+        drain();
+        lock.lock();
+        activeWorkers--;
+        finished.notify_one();
+    }
+}
+
+float simTime = 0.0f;
+
+// Game state
+float survivalTime = 0.0f;
+float highScore = 0.0f;
+bool gameStarted = false;
+float spawnTimer = 0.0f;
+float shootTimer = 0.0f;
+
+const size_t SIM_COP_BATCH = 64;
+const size_t SIM_BULLET_BATCH = 1024;
+
+// Outcomes of one update batch, applied after the join
+struct SimEvents {
+    int copHits;
+    int bulletHits;
+};
+
+ScriptedDrive scriptedDrive;
+
+void fireBullet(size_t cop) {
+    if (bullets.full()) {
+        bullets.rejected++;
+        return;
+    }
+    glm::vec3 copPos = policeCars.vec3(COP_X, cop);
+    glm::vec3 dir = glm::normalize(car.position - copPos);
+    glm::vec3 pos = copPos + glm::vec3(0, 1, 0);
+
+    size_t b = bullets.add();
+    bullets.setVec3(BULLET_X, b, pos);
+    bullets.setVec3(BULLET_VX, b, dir * 30.0f);
+    bullets.setVec3(BULLET_PREV_X, b, pos);
+    bullets[BULLET_LIFETIME][b] = 3.0f;
+    playSound(CLIP_GUNSHOT, pos);
+    emitParticles(EFFECT_MUZZLE, pos, dir);
+}
+
+void startGame() {
+    gameStarted = true;
+    survivalTime = 0.0f;
+    policeCars.clear();
+    bullets.clear();
+}
+
+void simulateTick(const InputState& input, float dt) {
+    PROFILE_ZONE("simulateTick");
+    if (input.start && !gameStarted) startGame();
+    if (!gameStarted) return;
+
+    car.savePrevious();
+    for (int c = 0; c < 3; c++) policeCars.columns[COP_PREV_X + c] = policeCars.columns[COP_X + c];
+    policeCars.columns[COP_PREV_ROTATION] = policeCars.columns[COP_ROTATION];
+    for (int c = 0; c < 3; c++) bullets.columns[BULLET_PREV_X + c] = bullets.columns[BULLET_X + c];
+
+    car.update(dt, input.forward, input.backward, input.left, input.right, input.drift);
+    simTime += dt;
+    if (scriptedDrive.active) scriptedDrive.apply(car, simTime);
+
+    survivalTime += dt;
+    if (survivalTime > highScore) highScore = survivalTime;
+    
+    spawnTimer += dt;
+    if (spawnTimer > 8.0f && policeCars.size() < 5) {
+        spawnPoliceCar();
+        spawnTimer = 0;
+    }
+    
+    // Filled by the AI and bullet batches, applied after the join
+    int copBatches, bulletBatches;
+    SimEvents* simEvents;
+    {
+        PROFILE_ZONE("ai+bullets");
+        shootTimer += dt;
+        if (shootTimer > 2.0f && !policeCars.empty()) {
+            fireBullet(0);
+            shootTimer = 0;
+        }
+
+        // Cops and bullets only read the car and the terrain, so batches run in
+        // parallel. Each batch records its hits; they are applied below in batch
+        // order, which keeps the outcome independent of the thread count.
+        flowField.update(car.position);
+        copBatches = (int)((policeCars.size() + SIM_COP_BATCH - 1) / SIM_COP_BATCH);
+        bulletBatches = (int)((bullets.size() + SIM_BULLET_BATCH - 1) / SIM_BULLET_BATCH);
+        simEvents = frameArena.allocArray<SimEvents>(copBatches + bulletBatches);
+        glm::vec3 target = car.position;
+
+        auto batch = [&](int b) {
+            SimEvents& events = simEvents[b];
+            events.copHits = 0;
+            events.bulletHits = 0;
+            if (b < copBatches) {
+                size_t begin = (size_t)b * SIM_COP_BATCH;
+                size_t end = std::min(begin + SIM_COP_BATCH, policeCars.size());
+                updatePoliceCars(policeCars, begin, end, dt, target);
+                for (size_t i = begin; i < end; i++) {
+                    glm::vec3 d = policeCars.vec3(COP_X, i) - target;
+                    if (glm::dot(d, d) < 3.0f * 3.0f) {
+                        glm::vec3 respawn = target + glm::vec3(50, 0, 50);
+                        policeCars.setVec3(COP_X, i, respawn);
+                        policeCars.setVec3(COP_PREV_X, i, respawn);    // teleport, don't interpolate
+                        events.copHits++;
+                    }
+                }
+            } else {
+                size_t begin = (size_t)(b - copBatches) * SIM_BULLET_BATCH;
+                size_t end = std::min(begin + SIM_BULLET_BATCH, bullets.size());
+                events.bulletHits = integrateBullets(bullets, begin, end, dt, target);
+            }
+        };
+        simJobs.run(copBatches + bulletBatches, batch);
+    }
+
+    for (int b = 0; b < copBatches; b++) {
+        for (int h = 0; h < simEvents[b].copHits; h++) {
+            survivalTime -= 5.0f;
+            if (survivalTime < 0) survivalTime = 0;
+            LOG_EVERY(LOG_LEVEL_INFO, 100, "HIT BY POLICE! -5 seconds");
+            playSound(CLIP_IMPACT, car.position);
+            emitParticles(EFFECT_SPARKS, car.position, glm::vec3(0.0f));
+        }
+    }
+    for (int b = copBatches; b < copBatches + bulletBatches; b++) {
+        for (int h = 0; h < simEvents[b].bulletHits; h++) {
+            survivalTime -= 1.0f;
+            if (survivalTime < 0) survivalTime = 0;
+            LOG_EVERY(LOG_LEVEL_INFO, 100, "SHOT! -1 second");
+            playSound(CLIP_IMPACT, car.position);
+            emitParticles(EFFECT_SPARKS, car.position, glm::vec3(0.0f));
+        }
+    }
+    const float* life = bullets[BULLET_LIFETIME];
+    for (size_t i = 0; i < bullets.size();) {
+        if (life[i] <= 0) bullets.swapRemove(i);
+        else i++;
+    }
+}
@@ -0,0 +1,244 @@
+#pragma once
+// Gameplay state and the fixed-tick simulation: the player's car, the cops
+// and their flow field, bullets, buildings and simulateTick(). Sounds and
+// particle effects a tick raises are queued for main.cpp to play and draw;
+// nothing here touches GL or audio.
+
+#include "entity_pool.h"
+#include "spatial_grid.h"
+#include "terrain.h"
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+enum AudioClip {
+    CLIP_SIREN,
+    CLIP_GUNSHOT,
+    CLIP_IMPACT,
+    CLIP_COUNT
+};
+
+enum ParticleEffect {
+    EFFECT_SMOKE,
+    EFFECT_SPLASH,
+    EFFECT_MUZZLE,
+    EFFECT_SPARKS,
+    EFFECT_TRACER,
+    EFFECT_COUNT
+};
+
+struct Building {
+    glm::vec3 position;
+    float width, depth, height;
+};
+
+extern std::vector<Building> buildings;
+extern int buildingGeneration;    // bumped by spawnBuildings; invalidates the flow field
+
+const float CAR_COLLISION_RADIUS = 2.5f;
+
+extern SpatialGrid buildingGrid;    // footprints padded by CAR_COLLISION_RADIUS
+
+// Random generator
+extern std::random_device rd;
+extern std::mt19937 gen;
+
+// Sounds raised by the sim; main.cpp hands them to the audio thread after
+// each frame's ticks. Without audio they are cleared unplayed.
+const int SOUND_EVENT_CAPACITY = 256;
+
+struct SoundEvent {
+    AudioClip clip;
+    glm::vec3 position;
+};
+
+extern SoundEvent soundEvents[SOUND_EVENT_CAPACITY];
+extern int soundEventCount;
+
+void playSound(AudioClip clip, const glm::vec3& position);
+
+const int PARTICLE_BURST_CAPACITY = 256;
+
+// One-shot effects raised by the sim, drained by the renderer each frame.
+// Headless nothing drains them; once full, further bursts are dropped.
+struct ParticleBurst {
+    ParticleEffect effect;
+    glm::vec3 position, direction;
+};
+
+extern ParticleBurst particleBursts[PARTICLE_BURST_CAPACITY];
+extern int particleBurstCount;
+
+void emitParticles(ParticleEffect effect, const glm::vec3& position, const glm::vec3& direction);
+
+const Building* findBuildingCollision(float x, float z);
+void spawnBuildings(int count = 10);
+void spawnPuddles(int count = 20);
+
+struct Car {
+    glm::vec3 position = glm::vec3(0, 0, 0);
+    float rotation = 0.0f;
+    float speed = 0.0f;
+    float steerAngle = 0.0f;
+    float driftAngle = 0.0f;
+    bool isDrifting = false;
+
+    // State at the start of the last sim tick, for render interpolation
+    glm::vec3 prevPosition = glm::vec3(0, 0, 0);
+    float prevRotation = 0.0f;
+    float prevDriftAngle = 0.0f;
+
+    void savePrevious() {
+        prevPosition = position;
+        prevRotation = rotation;
+        prevDriftAngle = driftAngle;
+    }
+
+    void update(float dt, bool forward, bool backward, bool left, bool right, bool drift);
+};
+
+extern Car car;
+extern CopPool policeCars;
+extern BulletPool bullets;
+
+// ---- Pursuit flow field ----
+// One shortest-path field around the player shared by every cop. Cells whose
+// centre lies in a building's padded footprint are walls; every other cell
+// stores which neighbour leads to the player fastest, so steering is one
+// lookup per cop. Rebuilt only when the player enters a new cell or the
+// buildings respawn.
+
+const float FLOW_CELL_SIZE = 4.0f;
+const int FLOW_GRID_SIDE = 96;              // 384 world units across, centred on the player
+const uint16_t FLOW_UNREACHED = 0xFFFF;
+const uint8_t FLOW_NONE = 0xFF;
+
+// 8-neighbourhood; orthogonal steps cost 2, diagonals 3
+static const int FLOW_DX[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+static const int FLOW_DZ[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+static const uint16_t FLOW_STEP_COST[8] = {2, 2, 2, 2, 3, 3, 3, 3};
+static const uint8_t FLOW_OPPOSITE[8] = {1, 0, 3, 2, 7, 6, 5, 4};
+
+struct FlowField {
+    int originX = 0, originZ = 0;           // world cell of grid cell (0, 0)
+    int targetCellX = 0, targetCellZ = 0;
+    int builtForBuildings = -1;             // buildingGeneration at the last rebuild
+    std::vector<uint8_t> blocked;
+    std::vector<uint16_t> cost;             // path cost to the player's cell
+    std::vector<uint8_t> next;              // neighbour to step to, FLOW_NONE at the target or if unreachable
+    std::vector<int> buckets[4];            // rebuild scratch, by cost mod 4
+    int rebuilds = 0;
+
+    static int cellOf(float v) { return (int)floor(v / FLOW_CELL_SIZE); }
+
+    void update(const glm::vec3& target);
+
+    // Unit XZ direction to follow from (x, z). False outside the field, in
+    // the player's cell or with no path; steer straight at the player then.
+    bool direction(float x, float z, glm::vec2& dir) const {
+        int cx = cellOf(x) - originX, cz = cellOf(z) - originZ;
+        if (next.empty() || cx < 0 || cz < 0 || cx >= FLOW_GRID_SIDE || cz >= FLOW_GRID_SIDE) return false;
+        uint8_t k = next[cz * FLOW_GRID_SIDE + cx];
+        if (k == FLOW_NONE) return false;
+        dir = glm::normalize(glm::vec2((float)FLOW_DX[k], (float)FLOW_DZ[k]));
+        return true;
+    }
+};
+
+extern FlowField flowField;
+
+// Steers cops [begin, end) toward targetPos
+void updatePoliceCars(CopPool& cops, size_t begin, size_t end, float dt, glm::vec3 targetPos);
+
+void spawnPoliceCar();
+
+// ---- Sim job pool ----
+// Fork-join helper for the per-tick AI and bullet updates. run() hands out
+// job indices from a shared counter to the helper threads and the calling
+// thread alike, and returns once every job has finished. Jobs are fixed-size
+// batches, so what each one computes never depends on the thread count.
+// The job is passed as a plain function pointer plus context, so issuing a
+// run allocates nothing (a capturing std::function would, every tick).
+
+struct SimJobPool {
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, finished;
+    void (*job)(void*, int) = nullptr;
+    void* jobContext = nullptr;
+    int jobCount = 0;
+    std::atomic<int> nextJob{0};
+    std::atomic<int> jobsDone{0};
+    int activeWorkers = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+
+    void start(int threadCount);
+    void stop();
+    void run(int count, void (*fn)(void*, int), void* context);
+    template <typename Job>
+    void run(int count, Job& fn) {
+        run(count, [](void* context, int j) { (*static_cast<Job*>(context))(j); }, &fn);
+    }
+    void drain();
+    void workerLoop();
+};
+
+extern SimJobPool simJobs;
+
+// ---- Simulation ----
+// Gameplay advances in fixed SIM_DT ticks fed from an accumulator, so the
+// outcome does not depend on frame rate. Nothing here touches GL: the
+// simulation can run with rendering throttled or switched off entirely.
+
+const float SIM_DT = 1.0f / 120.0f;
+const int MAX_SIM_STEPS_PER_FRAME = 12;     // 0.1s of catch-up, as before
+
+struct InputState {
+    bool forward = false, backward = false, left = false, right = false;
+    bool drift = false;
+    bool start = false;
+};
+
+extern float simTime;    // seconds simulated since launch
+
+// Game state
+extern float survivalTime;
+extern float highScore;
+extern bool gameStarted;
+extern float spawnTimer;
+extern float shootTimer;
+
+// Pins the car to a fixed high-speed loop (benchmarks). Car::update still
+// runs every tick so its cost is measured, then the pose is overridden.
+struct ScriptedDrive {
+    bool active = false;
+    float radius = 700.0f;
+    float speed = 45.0f;
+
+    // Circle through the origin, centred at (radius, 0)
+    void apply(Car& c, float t) const {
+        float angle = t * speed / radius;
+        c.position.x = radius - radius * std::cos(angle);
+        c.position.z = radius * std::sin(angle);
+        c.position.y = sampleTerrainHeight(c.position.x, c.position.z) + 0.5f;
+        c.rotation = angle;
+        c.speed = speed;
+    }
+};
+
+extern ScriptedDrive scriptedDrive;
+
+void fireBullet(size_t cop);
+
+void startGame();
+
+void simulateTick(const InputState& input, float dt);
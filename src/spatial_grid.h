@@ -0,0 +1,39 @@
+#pragma once
+// Uniform XZ grid, a quarter chunk per cell. Items are inserted into every
+// cell their footprint overlaps, so a point query reads exactly one cell.
+// Cell lists stay in insertion order, so the first hit matches the old
+// linear scan.
+
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+const float SPATIAL_CELL_SIZE = 16.0f;
+
+struct SpatialGrid {
+    std::unordered_map<long long, std::vector<int>> cells;
+
+    static long long key(int cx, int cz) {
+        return ((long long)cx << 32) | (unsigned int)cz;
+    }
+
+    static int cellOf(float v) {
+        return (int)floor(v / SPATIAL_CELL_SIZE);
+    }
+
+    void clear() { cells.clear(); }
+
+    void insert(int index, float minX, float minZ, float maxX, float maxZ) {
+        for (int cz = cellOf(minZ); cz <= cellOf(maxZ); cz++) {
+            for (int cx = cellOf(minX); cx <= cellOf(maxX); cx++) {
+                cells[key(cx, cz)].push_back(index);
+            }
+        }
+    }
+
+    // Candidates whose footprint may contain (x, z); nullptr if none
+    const std::vector<int>* query(float x, float z) const {
+        auto it = cells.find(key(cellOf(x), cellOf(z)));
+        return it == cells.end() ? nullptr : &it->second;
+    }
+};
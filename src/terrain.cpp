@@ -0,0 +1,167 @@
+#include "terrain.h"
+
+#include "terrain_noise.h"
+
+#include <cmath>
+
+std::vector<Puddle> puddles;
+SpatialGrid puddleGrid;
+
+TerrainLod terrainLods[LOD_COUNT];
+
+ChunkSlotPool chunkSlots;
+
+void ChunkSlotPool::init(int slotCount, int vertices) {
+    slotVertices = vertices;
+    freeSlots.clear();
+    for (int i = slotCount - 1; i >= 0; i--) freeSlots.push_back(i);    // hand out low slots first
+}
+
+int ChunkSlotPool::acquire() {
+    if (freeSlots.empty()) return -1;
+    int slot = freeSlots.back();
+    freeSlots.pop_back();
+    return slot;
+}
+
+HeightfieldPool heightfieldPool;
+
+ChunkTable chunks;
+
+int chunkLodForRing(int ring) {
+    for (int lod = 0; lod < LOD_COUNT - 1; lod++) {
+        if (ring <= LOD_MAX_RING[lod]) return lod;
+    }
+    return LOD_COUNT - 1;
+}
+
+void initTerrainLods() {
+    int firstIndex = 0;
+    for (int lod = 0; lod < LOD_COUNT; lod++) {
+        TerrainLod& l = terrainLods[lod];
+        l.step = 1 << lod;
+        l.tiles = CHUNK_SIZE / l.step;
+        l.side = l.tiles + 1;
+        l.vertexCount = l.side * l.side + 4 * l.tiles;
+        l.indexCount = (l.tiles * l.tiles + 4 * l.tiles) * 6;
+        l.firstIndex = firstIndex;
+        firstIndex += l.indexCount;
+    }
+}
+
+void skirtGridPos(int k, int tiles, int& x, int& z) {
+    int edge = k / tiles, t = k % tiles;
+    if (edge == 0)      { x = t;         z = 0; }
+    else if (edge == 1) { x = tiles;     z = t; }
+    else if (edge == 2) { x = tiles - t; z = tiles; }
+    else                { x = 0;         z = tiles - t; }
+}
+
+static inline float bilerp(float h00, float h10, float h01, float h11, float fx, float fz) {
+    return (h00 * (1 - fx) + h10 * fx) * (1 - fz) + (h01 * (1 - fx) + h11 * fx) * fz;
+}
+
+// Type of tile (tx, tz), judged at its centre
+static TerrainType tileType(int tx, int tz, float h00, float h10, float h01, float h11) {
+    float height = (h00 + h10 + h01 + h11) * 0.25f;
+    TerrainType type;
+    if (height < 0.5f) {
+        type = TERRAIN_ROAD;
+    } else if (height < 3.0f) {
+        type = TERRAIN_GRASS;
+    } else {
+        type = TERRAIN_DIRT;
+    }
+
+    glm::vec2 center((tx + 0.5f) * TILE_SIZE, (tz + 0.5f) * TILE_SIZE);
+    if (const std::vector<int>* nearby = puddleGrid.query(center.x, center.y)) {
+        for (int i : *nearby) {
+            const Puddle& p = puddles[i];
+            glm::vec2 d = center - p.pos;
+            if (glm::dot(d, d) < p.radius * p.radius) return TERRAIN_PUDDLE;
+        }
+    }
+    return type;
+}
+
+void buildTileTypes(Heightfield& field, int chunkX, int chunkZ) {
+    for (int z = 0; z < CHUNK_SIZE; z++) {
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            const float* h = field.heights + z * FULL_GRID_SIDE + x;
+            field.types[z * CHUNK_SIZE + x] = (uint8_t)tileType(chunkX * CHUNK_SIZE + x, chunkZ * CHUNK_SIZE + z,
+                                                               h[0], h[1], h[FULL_GRID_SIDE], h[FULL_GRID_SIDE + 1]);
+        }
+    }
+}
+
+void rebuildResidentTileTypes() {
+    for (const ChunkTable::Cell& cell : chunks.cells) {
+        if (!cell.resident || cell.chunk.heightfield < 0) continue;
+        buildTileTypes(heightfieldPool.entries[cell.chunk.heightfield], cell.chunk.x, cell.chunk.z);
+    }
+}
+
+// The tile under (x, z): its corners, the position inside it, and the
+// heightfield that supplied them (nullptr when they were generated)
+struct TileSample {
+    int tx, tz;
+    int localX, localZ;
+    float fx, fz;
+    float h00, h10, h01, h11;
+    Heightfield* field;
+};
+
+static void sampleTile(float x, float z, TileSample& t) {
+    float gx = x / TILE_SIZE, gz = z / TILE_SIZE;
+    t.tx = (int)floor(gx);
+    t.tz = (int)floor(gz);
+    t.fx = gx - t.tx;
+    t.fz = gz - t.tz;
+
+    int chunkX = (int)floor((float)t.tx / CHUNK_SIZE);
+    int chunkZ = (int)floor((float)t.tz / CHUNK_SIZE);
+    t.localX = t.tx - chunkX * CHUNK_SIZE;
+    t.localZ = t.tz - chunkZ * CHUNK_SIZE;
+
+    ChunkTable::Cell* cell = chunks.cell(chunkX, chunkZ);
+    t.field = cell && cell->resident && cell->chunk.heightfield >= 0
+        ? &heightfieldPool.entries[cell->chunk.heightfield] : nullptr;
+
+    if (t.field) {
+        const float* h = t.field->heights + t.localZ * FULL_GRID_SIDE + t.localX;
+        t.h00 = h[0];
+        t.h10 = h[1];
+        t.h01 = h[FULL_GRID_SIDE];
+        t.h11 = h[FULL_GRID_SIDE + 1];
+    } else {
+        float x0 = t.tx * TILE_SIZE, x1 = (t.tx + 1) * TILE_SIZE;
+        float z0 = t.tz * TILE_SIZE, z1 = (t.tz + 1) * TILE_SIZE;
+        const float xs[4] = {x0, x1, x0, x1}, zs[4] = {z0, z0, z1, z1};
+        float h[4];
+        getTerrainHeightBatch(xs, zs, h, 4);
+        t.h00 = h[0];
+        t.h10 = h[1];
+        t.h01 = h[2];
+        t.h11 = h[3];
+    }
+}
+
+float sampleTerrainHeight(float x, float z) {
+    TileSample t;
+    sampleTile(x, z, t);
+    return bilerp(t.h00, t.h10, t.h01, t.h11, t.fx, t.fz);
+}
+
+TerrainInfo getTerrainInfo(float x, float z) {
+    TileSample t;
+    sampleTile(x, z, t);
+    float height = bilerp(t.h00, t.h10, t.h01, t.h11, t.fx, t.fz);
+
+    TerrainType type;
+    if (t.field) {
+        type = (TerrainType)t.field->types[t.localZ * CHUNK_SIZE + t.localX];
+    } else {
+        type = tileType(t.tx, t.tz, t.h00, t.h10, t.h01, t.h11);
+    }
+    return {height, type};
+}
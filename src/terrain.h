@@ -0,0 +1,199 @@
+#pragma once
+// Gameplay terrain: tile types and puddles, the chunk and LOD layout the
+// meshes follow, the table of resident chunks, and height queries that
+// read their LOD 0 heightfields. Nothing here touches GL.
+
+#include "spatial_grid.h"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+enum TerrainType {
+    TERRAIN_ROAD,
+    TERRAIN_GRASS,
+    TERRAIN_DIRT,
+    TERRAIN_PUDDLE
+};
+
+struct TerrainInfo {
+    float height;
+    TerrainType type;
+};
+
+struct Puddle {
+    glm::vec2 pos;
+    float radius;
+};
+
+// Placed by spawnPuddles()
+extern std::vector<Puddle> puddles;
+extern SpatialGrid puddleGrid;
+
+const int CHUNK_SIZE = 32;
+const float TILE_SIZE = 2.0f;
+const int FULL_GRID_SIDE = CHUNK_SIZE + 1;     // LOD 0 vertices per side
+const int FULL_GRID_VERTS = FULL_GRID_SIDE * FULL_GRID_SIDE;
+const int RENDER_DISTANCE = 15;
+const int CHUNK_KEEP_RADIUS = RENDER_DISTANCE + 2;  // evicted beyond this ring
+
+// Level of detail by Chebyshev ring around the car's chunk. LOD l samples
+// every (1 << l)th grid point, so a chunk has 32/16/8/4 tiles per side.
+// Near the outer edge of its band a chunk geomorphs toward the next LOD's
+// surface, so it matches its coarser neighbour exactly where they meet.
+const int LOD_COUNT = 4;
+const int LOD_MAX_RING[LOD_COUNT] = {2, 5, 9, RENDER_DISTANCE};
+const float LOD_MORPH_WIDTH = 1.0f;     // chunks, at the end of each band
+const float SKIRT_DEPTH = 4.0f;         // per LOD step; hides residual cracks
+
+int chunkLodForRing(int ring);
+
+// Terrain vertices are (height, morph target height); local XZ comes from
+// gl_VertexID less the slot's base vertex: a side x side grid, then a skirt
+// ring of 4 * tiles vertices hanging below the border. Every chunk of a LOD draws the same section of
+// one static 16-bit index buffer.
+struct TerrainLod {
+    int step;           // grid points per vertex
+    int tiles;          // quads per side
+    int side;           // vertices per side
+    int vertexCount;    // grid + skirt
+    int indexCount;
+    int firstIndex;     // offset into terrainIndexEBO
+};
+
+extern TerrainLod terrainLods[LOD_COUNT];
+
+void initTerrainLods();
+
+// Grid coordinates of skirt vertex k, walking the border clockwise from (0, 0)
+void skirtGridPos(int k, int tiles, int& x, int& z);
+
+struct Chunk {
+    int x, z;
+    int lod;
+    int slot;                       // chunkSlots slot, -1 when there is no mesh
+    int heightfield;                // heightfieldPool entry, -1 when not LOD 0
+    float minHeight, maxHeight;     // vertical extent of the AABB, for culling
+};
+
+// Free slots of the shared chunk vertex buffer (ChunkBufferPool in
+// main.cpp). The bookkeeping lives here so eviction needs no GL context.
+struct ChunkSlotPool {
+    int slotVertices = 0;
+    std::vector<int> freeSlots;
+
+    void init(int slotCount, int vertices);
+    int acquire();                  // -1 when full
+    void release(int slot) { if (slot >= 0) freeSlots.push_back(slot); }
+    int baseVertex(int slot) const { return slot * slotVertices; }
+};
+
+extern ChunkSlotPool chunkSlots;
+
+// CPU copy of a LOD 0 chunk's heights for gameplay queries, plus the
+// terrain type of each tile (sampled at the tile centre). Types are built
+// on the main thread when the chunk is uploaded and when the puddles
+// respawn, so queries, including those from sim helper threads, only read.
+struct Heightfield {
+    float heights[FULL_GRID_VERTS];
+    uint8_t types[CHUNK_SIZE * CHUNK_SIZE];
+};
+
+// Rings 0..LOD_MAX_RING[0] plus the ring just outside, whose LOD 0 meshes
+// survive until their coarser rebuild lands
+const int HEIGHTFIELD_CAPACITY = (2 * LOD_MAX_RING[0] + 3) * (2 * LOD_MAX_RING[0] + 3);
+
+struct HeightfieldPool {
+    Heightfield entries[HEIGHTFIELD_CAPACITY];
+    std::vector<int> freeEntries;
+
+    HeightfieldPool() {
+        for (int i = HEIGHTFIELD_CAPACITY - 1; i >= 0; i--) freeEntries.push_back(i);
+    }
+    int acquire() {
+        if (freeEntries.empty()) return -1;     // queries fall back to the generator
+        int i = freeEntries.back();
+        freeEntries.pop_back();
+        return i;
+    }
+    void release(int i) { if (i >= 0) freeEntries.push_back(i); }
+};
+
+extern HeightfieldPool heightfieldPool;
+
+// Resident chunks live in a toroidal SIDE x SIDE grid indexed by
+// (x mod SIDE, z mod SIDE). SIDE equals the keep window, so every chunk in
+// the window has its own cell and lookups are one array access. Moving the
+// window evicts only the rows and columns that left it.
+struct ChunkTable {
+    static const int SIDE = 2 * CHUNK_KEEP_RADIUS + 1;
+
+    struct Cell {
+        Chunk chunk;
+        bool resident = false;
+        bool requested = false;     // a mesh for this cell is queued or in flight
+    };
+
+    Cell cells[SIDE * SIDE];
+    int centerX = 0, centerZ = 0;
+
+    static int wrap(int v) {
+        int m = v % SIDE;
+        return m < 0 ? m + SIDE : m;
+    }
+
+    bool inWindow(int x, int z) const {
+        return abs(x - centerX) <= CHUNK_KEEP_RADIUS && abs(z - centerZ) <= CHUNK_KEEP_RADIUS;
+    }
+
+    // nullptr outside the window
+    Cell* cell(int x, int z) {
+        return inWindow(x, z) ? &cells[wrap(z) * SIDE + wrap(x)] : nullptr;
+    }
+
+    void evict(Cell& c) {
+        if (c.resident) {
+            chunkSlots.release(c.chunk.slot);
+            heightfieldPool.release(c.chunk.heightfield);
+        }
+        c.resident = false;
+        c.requested = false;    // an in-flight mesh is dropped on arrival
+    }
+
+    void recenter(int newX, int newZ) {
+        int dx = newX - centerX, dz = newZ - centerZ;
+        if (abs(dx) >= SIDE || abs(dz) >= SIDE) {
+            for (Cell& c : cells) evict(c);
+        } else {
+            // Columns, then rows, of the old window that the new one drops
+            for (int i = 0; i < abs(dx); i++) {
+                int x = dx > 0 ? centerX - CHUNK_KEEP_RADIUS + i : centerX + CHUNK_KEEP_RADIUS - i;
+                for (int z = 0; z < SIDE; z++) evict(cells[z * SIDE + wrap(x)]);
+            }
+            for (int i = 0; i < abs(dz); i++) {
+                int z = dz > 0 ? centerZ - CHUNK_KEEP_RADIUS + i : centerZ + CHUNK_KEEP_RADIUS - i;
+                for (int x = 0; x < SIDE; x++) evict(cells[wrap(z) * SIDE + x]);
+            }
+        }
+        centerX = newX;
+        centerZ = newZ;
+    }
+};
+
+extern ChunkTable chunks;
+
+// Gameplay samples the terrain bilinearly between the full-resolution grid
+// points the LOD 0 mesh uses. Resident LOD 0 chunks answer from their
+// Heightfield; anywhere else the tile's four corners come from the
+// generator in one batch. Both paths give bit-identical results, so the
+// simulation never depends on what happens to be streamed in.
+
+float sampleTerrainHeight(float x, float z);
+
+TerrainInfo getTerrainInfo(float x, float z);
+
+void buildTileTypes(Heightfield& field, int chunkX, int chunkZ);
+
+// After a puddle respawn; main thread, outside the sim update
+void rebuildResidentTileTypes();
@@ -0,0 +1,273 @@
+#include "terrain_cache.h"
+
+#include "profiler.h"
+#include "terrain_noise.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+bool MappedFile::open(const char* path) {
+#ifdef _WIN32
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        close();
+        return false;
+    }
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping) data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        close();
+        return false;
+    }
+    size = (size_t)fileSize.QuadPart;
+#else
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);    // the mapping keeps the file alive
+    if (p == MAP_FAILED) return false;
+    data = (const unsigned char*)p;
+    size = (size_t)st.st_size;
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+    if (data) UnmapViewOfFile(data);
+    if (mapping) CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+    mapping = NULL;
+    file = INVALID_HANDLE_VALUE;
+#else
+    if (data) munmap((void*)data, size);
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+TerrainCache terrainCache;
+
+void sampleChunkHeights(int chunkX, int chunkZ, float* heights) {
+    if (terrainCache.lookup(chunkX, chunkZ, heights)) return;
+
+    float gridX[FULL_GRID_VERTS], gridZ[FULL_GRID_VERTS];
+    for (int z = 0; z <= CHUNK_SIZE; z++) {
+        for (int x = 0; x <= CHUNK_SIZE; x++) {
+            gridX[z * FULL_GRID_SIDE + x] = (chunkX * CHUNK_SIZE + x) * TILE_SIZE;
+            gridZ[z * FULL_GRID_SIDE + x] = (chunkZ * CHUNK_SIZE + z) * TILE_SIZE;
+        }
+    }
+    getTerrainHeightBatch(gridX, gridZ, heights, FULL_GRID_VERTS);
+    terrainCache.store(chunkX, chunkZ, heights);
+}
+
+// FNV-1a over the format constants and a spread of generator samples, so
+// any change to noise() or getTerrainHeight() invalidates old files
+uint64_t TerrainCache::fingerprint() {
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&](const void* data, size_t n) {
+        const unsigned char* p = (const unsigned char*)data;
+        for (size_t i = 0; i < n; i++) h = (h ^ p[i]) * 1099511628211ull;
+    };
+    uint32_t constants[] = {TERRAIN_GENERATOR_VERSION, (uint32_t)CHUNK_SIZE, (uint32_t)FULL_GRID_VERTS};
+    mix(constants, sizeof(constants));
+    mix(&TILE_SIZE, sizeof(TILE_SIZE));
+    for (int i = 0; i < 64; i++) {
+        float x = (i * 7919 % 4001 - 2000) * 3.7f, z = (i * 104729 % 4003 - 2000) * 2.9f;
+        float height = getTerrainHeight(x, z);
+        mix(&height, sizeof(height));
+    }
+    return h;
+}
+
+void TerrainCache::open(const std::string& cachePath) {
+    enabled = true;
+    path = cachePath;
+    generatorHash = fingerprint();
+    addedHeights.assign((size_t)CACHE_ADDED_CAPACITY * FULL_GRID_VERTS, 0.0f);
+    addedKeys.assign(CACHE_ADDED_CAPACITY, 0);
+    addedSlots.assign((size_t)1 << CACHE_ADDED_SLOT_BITS, -1);
+    addedCount = 0;
+    if (!file.open(path.c_str())) return;   // no cache yet: created at exit
+
+    bool valid = file.size >= sizeof(CacheHeader) + sizeof(CacheTrailer);
+    CacheHeader header;
+    CacheTrailer trailer;
+    const uint64_t recordBytes = FULL_GRID_VERTS * sizeof(float);
+    if (valid) {
+        memcpy(&header, file.data, sizeof(header));
+        memcpy(&trailer, file.data + file.size - sizeof(trailer), sizeof(trailer));
+        // Bounds are checked before anything is multiplied, so a crafted
+        // count or offset cannot wrap its way past them
+        const uint64_t indexEnd = file.size - sizeof(trailer);
+        valid = memcmp(header.magic, "GT7C", 4) == 0 && memcmp(trailer.magic, "GT7C", 4) == 0 &&
+                header.version == CACHE_FORMAT_VERSION && header.gridVerts == FULL_GRID_VERTS &&
+                header.generatorHash == generatorHash && trailer.generatorHash == generatorHash &&
+                trailer.indexOffset >= sizeof(header) && trailer.indexOffset <= indexEnd &&
+                trailer.count <= (indexEnd - trailer.indexOffset) / sizeof(CacheIndexEntry) &&
+                trailer.indexOffset + trailer.count * sizeof(CacheIndexEntry) == indexEnd &&
+                trailer.count <= (trailer.indexOffset - sizeof(header)) / recordBytes;
+    }
+    if (!valid) {
+        std::cout << "Terrain cache " << path << " is stale or corrupt, rebuilding\n";
+        file.close();
+        return;
+    }
+
+    for (uint64_t i = 0; i < trailer.count; i++) {
+        CacheIndexEntry entry;
+        memcpy(&entry, file.data + trailer.indexOffset + i * sizeof(entry), sizeof(entry));
+        if (entry.offset < sizeof(CacheHeader) || entry.offset > trailer.indexOffset - recordBytes) continue;
+        mapped[key(entry.x, entry.z)] = (const float*)(file.data + entry.offset);
+    }
+    std::cout << "Terrain cache: " << mapped.size() << " chunks mapped from " << path << "\n";
+}
+
+bool TerrainCache::lookup(int x, int z, float* heights) {
+    if (!enabled) return false;
+    std::lock_guard<std::mutex> lock(mutex);
+    const float* src = nullptr;
+    auto it = mapped.find(key(x, z));
+    if (it != mapped.end()) {
+        src = it->second;
+    } else {
+        src = findAdded(key(x, z));
+    }
+    if (!src) {
+        misses++;
+        return false;
+    }
+    memcpy(heights, src, FULL_GRID_VERTS * sizeof(float));    // page-in happens here
+    hits++;
+    return true;
+}
+
+const float* TerrainCache::findAdded(long long k) const {
+    const int mask = (1 << CACHE_ADDED_SLOT_BITS) - 1;
+    for (int s = slotOf(k); addedSlots[s] >= 0; s = (s + 1) & mask) {
+        int record = addedSlots[s];
+        if (addedKeys[record] == k) return &addedHeights[(size_t)record * FULL_GRID_VERTS];
+    }
+    return nullptr;
+}
+
+void TerrainCache::store(int x, int z, const float* heights) {
+    if (!enabled) return;
+    long long k = key(x, z);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (mapped.count(k) || findAdded(k)) return;
+    if (addedCount == CACHE_ADDED_CAPACITY) {
+        dropped++;
+        return;
+    }
+    const int mask = (1 << CACHE_ADDED_SLOT_BITS) - 1;
+    int s = slotOf(k);
+    while (addedSlots[s] >= 0) s = (s + 1) & mask;
+    addedSlots[s] = addedCount;
+    addedKeys[addedCount] = k;
+    memcpy(&addedHeights[(size_t)addedCount * FULL_GRID_VERTS], heights, FULL_GRID_VERTS * sizeof(float));
+    addedCount++;
+}
+
+// Pages the mapped file in and fills in the spawn window, off the main thread
+void TerrainCache::startWarming(int centerX, int centerZ, int radius) {
+    if (!enabled) return;
+    warmer = std::thread([this, centerX, centerZ, radius] {
+        PROFILE_ZONE("terrainCache.warm");
+        volatile unsigned char sink = 0;
+        for (size_t offset = 0; offset < file.size && !stopWarming; offset += 4096) sink = sink + file.data[offset];
+
+        std::vector<float> heights(FULL_GRID_VERTS);
+        for (int ring = 0; ring <= radius && !stopWarming; ring++) {
+            for (int z = centerZ - ring; z <= centerZ + ring; z++) {
+                for (int x = centerX - ring; x <= centerX + ring; x++) {
+                    if (std::max(abs(x - centerX), abs(z - centerZ)) != ring) continue;
+                    bool cached;
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        cached = mapped.count(key(x, z)) || findAdded(key(x, z));
+                    }
+                    if (!cached) sampleChunkHeights(x, z, heights.data());
+                }
+            }
+        }
+    });
+}
+
+size_t TerrainCache::entryCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return mapped.size() + addedCount;
+}
+
+size_t TerrainCache::bytes() {
+    return sizeof(CacheHeader) + sizeof(CacheTrailer) +
+           entryCount() * (FULL_GRID_VERTS * sizeof(float) + sizeof(CacheIndexEntry));
+}
+
+void TerrainCache::close() {
+    if (!enabled) return;
+    stopWarming = true;
+    if (warmer.joinable()) warmer.join();
+    enabled = false;
+    if (dropped > 0) std::cout << "Terrain cache full: " << dropped.load() << " chunk builds were not cached\n";
+
+    if (addedCount == 0) {
+        file.close();
+        return;
+    }
+
+    // Write old and new records to a temp file, then swap it in
+    std::string tmpPath = path + ".tmp";
+    FILE* f = fopen(tmpPath.c_str(), "wb");
+    if (!f) {
+        std::cout << "Failed to write terrain cache " << tmpPath << "\n";
+        file.close();
+        return;
+    }
+
+    CacheHeader header = {{'G', 'T', '7', 'C'}, CACHE_FORMAT_VERSION, generatorHash, (uint32_t)FULL_GRID_VERTS, 0};
+    fwrite(&header, sizeof(header), 1, f);
+
+    std::vector<CacheIndexEntry> index;
+    index.reserve(mapped.size() + addedCount);
+    uint64_t offset = sizeof(header);
+    auto writeRecord = [&](long long k, const float* heights) {
+        fwrite(heights, sizeof(float), FULL_GRID_VERTS, f);
+        index.push_back({(int32_t)(k >> 32), (int32_t)(k & 0xffffffff), offset});
+        offset += FULL_GRID_VERTS * sizeof(float);
+    };
+    for (auto& entry : mapped) writeRecord(entry.first, entry.second);
+    for (int i = 0; i < addedCount; i++) writeRecord(addedKeys[i], &addedHeights[(size_t)i * FULL_GRID_VERTS]);
+
+    fwrite(index.data(), sizeof(CacheIndexEntry), index.size(), f);
+    CacheTrailer trailer = {offset, (uint64_t)index.size(), generatorHash, {'G', 'T', '7', 'C'}, 0};
+    fwrite(&trailer, sizeof(trailer), 1, f);
+    bool ok = ferror(f) == 0;
+    fclose(f);
+
+    file.close();   // unmap before replacing the file (required on Windows)
+    mapped.clear();
+    if (ok) {
+        std::remove(path.c_str());
+        ok = std::rename(tmpPath.c_str(), path.c_str()) == 0;
+    }
+    if (ok) std::cout << "Terrain cache: " << index.size() << " chunks written to " << path << "\n";
+    else std::cout << "Failed to write terrain cache " << path << "\n";
+}
@@ -0,0 +1,106 @@
+#pragma once
+// Optional on-disk store of full-resolution chunk heights (--terrain-cache).
+// Coarser LODs subsample the same grid, so one record serves every LOD.
+// The file is memory-mapped read-only; chunks generated this session are
+// kept in memory and the file is rewritten at exit.
+//
+// Layout, little-endian:
+//   CacheHeader
+//   float heights[FULL_GRID_VERTS] per record
+//   CacheIndexEntry per record       (index footer)
+//   CacheTrailer                     (last bytes of the file)
+
+#include "terrain.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#endif
+
+const uint32_t CACHE_FORMAT_VERSION = 1;
+const uint32_t TERRAIN_GENERATOR_VERSION = 1;   // bump when the noise changes
+
+// Chunks generated in one session are kept in a slab allocated by open()
+// (about 18 MB) and written out at exit. Past the cap, new chunks are
+// still generated but not cached, so a long drive cannot grow it.
+const int CACHE_ADDED_CAPACITY = 4096;
+const int CACHE_ADDED_SLOT_BITS = 13;           // open-addressed key table, twice the capacity
+
+struct CacheHeader {
+    char magic[4];              // "GT7C"
+    uint32_t version;
+    uint64_t generatorHash;
+    uint32_t gridVerts;
+    uint32_t reserved;
+};
+
+struct CacheIndexEntry {
+    int32_t x, z;
+    uint64_t offset;            // byte offset of the record
+};
+
+struct CacheTrailer {
+    uint64_t indexOffset;
+    uint64_t count;
+    uint64_t generatorHash;
+    char magic[4];
+    uint32_t reserved;
+};
+
+// Read-only file mapping
+struct MappedFile {
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE, mapping = NULL;
+#endif
+
+    bool open(const char* path);
+    void close();
+};
+
+struct TerrainCache {
+    bool enabled = false;
+    std::string path;
+    uint64_t generatorHash = 0;
+    MappedFile file;
+
+    std::mutex mutex;
+    std::unordered_map<long long, const float*> mapped;         // records in the file
+    std::vector<float> addedHeights;        // generated this session, CACHE_ADDED_CAPACITY records
+    std::vector<long long> addedKeys;       // key of each added record
+    std::vector<int> addedSlots;            // key table into the records, -1 when empty
+    int addedCount = 0;
+    std::atomic<int> hits{0}, misses{0};
+    std::atomic<int> dropped{0};            // chunk builds after the slab filled up
+
+    std::thread warmer;
+    std::atomic<bool> stopWarming{false};
+
+    static long long key(int x, int z) { return ((long long)x << 32) | (unsigned int)z; }
+    static uint64_t fingerprint();
+    static int slotOf(long long k) { return (int)(((uint64_t)k * 0x9E3779B97F4A7C15ull) >> (64 - CACHE_ADDED_SLOT_BITS)); }
+    const float* findAdded(long long k) const;  // caller holds mutex
+
+    void open(const std::string& cachePath);
+    bool lookup(int x, int z, float* heights);
+    void store(int x, int z, const float* heights);
+    void startWarming(int centerX, int centerZ, int radius);
+    void close();           // joins the warmer and writes the file
+    size_t entryCount();
+    size_t bytes();
+};
+
+extern TerrainCache terrainCache;
+
+// Full-resolution heights of one chunk, from the cache when it has them
+void sampleChunkHeights(int chunkX, int chunkZ, float* heights);
@@ -0,0 +1,273 @@
+#include "terrain_noise.h"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define TERRAIN_BASELINE_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #include <arm_neon.h>
+    #define TERRAIN_BASELINE_NEON
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <intrin.h>
+#endif
+
+// Hash for the noise lattice. Unsigned wrap-around keeps the overflow
+// well defined; the SIMD kernels below reproduce it lane for lane.
+static inline int latticeHash(int a, int b) {
+    int h = (int)((unsigned)a * 374761393u + (unsigned)b * 668265263u);
+    h = (int)((unsigned)(h ^ (h >> 13)) * 1274126177u);
+    return h & 0x7fffffff;
+}
+
+float noise(float x, float z) {
+    int xi = (int)floor(x);
+    int zi = (int)floor(z);
+    float xf = x - xi;
+    float zf = z - zi;
+    
+    auto hash = [](int a, int b) {
+        return latticeHash(a, b) / (float)0x7fffffff;
+    };
+    
+    float a = hash(xi, zi);
+    float b = hash(xi + 1, zi);
+    float c = hash(xi, zi + 1);
+    float d = hash(xi + 1, zi + 1);
+    
+    auto smoothstep = [](float t) { return t * t * (3.0f - 2.0f * t); };
+    float u = smoothstep(xf);
+    float v = smoothstep(zf);
+    
+    return a * (1-u) * (1-v) + b * u * (1-v) + c * (1-u) * v + d * u * v;
+}
+
+float getTerrainHeight(float x, float z) {
+    float height = 0;
+    float scale = 0.02f;
+    height += noise(x * scale, z * scale) * 5.0f;
+    height += noise(x * scale * 2, z * scale * 2) * 2.0f;
+    height += noise(x * scale * 4, z * scale * 4) * 0.5f;
+    return height;
+}
+
+// ---- Batched terrain sampling ----
+// Every kernel performs the exact operation sequence of noise() and
+// getTerrainHeight() (no FMA, no reciprocal tricks), so batch heights are
+// bit-identical to scalar queries and the mesh agrees with gameplay.
+// SSE2 (x86-64) and NEON (arm64) are baseline and built here; AVX2 is in
+// terrain_noise_avx2.cpp and only runs after a CPUID check.
+
+#if defined(TERRAIN_BASELINE_SSE2)
+
+
+// SSE2 has no 32-bit low multiply; build it from two 32x32->64 products
+static inline __m128i mullo32(__m128i a, __m128i b) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// (int)floor(x) without SSE4.1: truncate, then step down where that rounded up
+static inline __m128i floorToInt4(__m128 x) {
+    __m128i t = _mm_cvttps_epi32(x);
+    __m128 roundedUp = _mm_cmpgt_ps(_mm_cvtepi32_ps(t), x);
+    return _mm_add_epi32(t, _mm_castps_si128(roundedUp));
+}
+
+static inline __m128 hashToUnit4(__m128i a, __m128i b) {
+    __m128i h = _mm_add_epi32(mullo32(a, _mm_set1_epi32(374761393)),
+                              mullo32(b, _mm_set1_epi32(668265263)));
+    h = _mm_xor_si128(h, _mm_srai_epi32(h, 13));
+    h = mullo32(h, _mm_set1_epi32(1274126177));
+    h = _mm_and_si128(h, _mm_set1_epi32(0x7fffffff));
+    return _mm_div_ps(_mm_cvtepi32_ps(h), _mm_set1_ps((float)0x7fffffff));
+}
+
+static inline __m128 noise4(__m128 x, __m128 z) {
+    __m128i xi = floorToInt4(x);
+    __m128i zi = floorToInt4(z);
+    __m128 xf = _mm_sub_ps(x, _mm_cvtepi32_ps(xi));
+    __m128 zf = _mm_sub_ps(z, _mm_cvtepi32_ps(zi));
+
+    __m128i one = _mm_set1_epi32(1);
+    __m128i xi1 = _mm_add_epi32(xi, one);
+    __m128i zi1 = _mm_add_epi32(zi, one);
+    __m128 a = hashToUnit4(xi, zi);
+    __m128 b = hashToUnit4(xi1, zi);
+    __m128 c = hashToUnit4(xi, zi1);
+    __m128 d = hashToUnit4(xi1, zi1);
+
+    __m128 three = _mm_set1_ps(3.0f), two = _mm_set1_ps(2.0f), onef = _mm_set1_ps(1.0f);
+    __m128 u = _mm_mul_ps(_mm_mul_ps(xf, xf), _mm_sub_ps(three, _mm_mul_ps(two, xf)));
+    __m128 v = _mm_mul_ps(_mm_mul_ps(zf, zf), _mm_sub_ps(three, _mm_mul_ps(two, zf)));
+    __m128 iu = _mm_sub_ps(onef, u);
+    __m128 iv = _mm_sub_ps(onef, v);
+
+    __m128 r = _mm_mul_ps(_mm_mul_ps(a, iu), iv);
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(b, u), iv));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(c, iu), v));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(d, u), v));
+    return r;
+}
+
+static inline void terrainHeightBlock(const float* xs, const float* zs, float* out) {
+    __m128 scale = _mm_set1_ps(0.02f);
+    __m128 x1 = _mm_mul_ps(_mm_loadu_ps(xs), scale);
+    __m128 z1 = _mm_mul_ps(_mm_loadu_ps(zs), scale);
+    __m128 x2 = _mm_mul_ps(x1, _mm_set1_ps(2.0f)), z2 = _mm_mul_ps(z1, _mm_set1_ps(2.0f));
+    __m128 x4 = _mm_mul_ps(x1, _mm_set1_ps(4.0f)), z4 = _mm_mul_ps(z1, _mm_set1_ps(4.0f));
+    __m128 h = _mm_mul_ps(noise4(x1, z1), _mm_set1_ps(5.0f));
+    h = _mm_add_ps(h, _mm_mul_ps(noise4(x2, z2), _mm_set1_ps(2.0f)));
+    h = _mm_add_ps(h, _mm_mul_ps(noise4(x4, z4), _mm_set1_ps(0.5f)));
+    _mm_storeu_ps(out, h);
+}
+
+static size_t terrainHeightBatchSse2(const float* xs, const float* zs, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) terrainHeightBlock(xs + i, zs + i, out + i);
+    return i;
+}
+
+#elif defined(TERRAIN_BASELINE_NEON)
+
+
+static inline float32x4_t hashToUnit4(int32x4_t a, int32x4_t b) {
+    int32x4_t h = vaddq_s32(vmulq_s32(a, vdupq_n_s32(374761393)),
+                            vmulq_s32(b, vdupq_n_s32(668265263)));
+    h = veorq_s32(h, vshrq_n_s32(h, 13));
+    h = vmulq_s32(h, vdupq_n_s32(1274126177));
+    h = vandq_s32(h, vdupq_n_s32(0x7fffffff));
+    return vdivq_f32(vcvtq_f32_s32(h), vdupq_n_f32((float)0x7fffffff));
+}
+
+static inline float32x4_t noise4(float32x4_t x, float32x4_t z) {
+    int32x4_t xi = vcvtmq_s32_f32(x);    // round toward -inf == (int)floor(x)
+    int32x4_t zi = vcvtmq_s32_f32(z);
+    float32x4_t xf = vsubq_f32(x, vcvtq_f32_s32(xi));
+    float32x4_t zf = vsubq_f32(z, vcvtq_f32_s32(zi));
+
+    int32x4_t one = vdupq_n_s32(1);
+    int32x4_t xi1 = vaddq_s32(xi, one);
+    int32x4_t zi1 = vaddq_s32(zi, one);
+    float32x4_t a = hashToUnit4(xi, zi);
+    float32x4_t b = hashToUnit4(xi1, zi);
+    float32x4_t c = hashToUnit4(xi, zi1);
+    float32x4_t d = hashToUnit4(xi1, zi1);
+
+    float32x4_t three = vdupq_n_f32(3.0f), two = vdupq_n_f32(2.0f), onef = vdupq_n_f32(1.0f);
+    float32x4_t u = vmulq_f32(vmulq_f32(xf, xf), vsubq_f32(three, vmulq_f32(two, xf)));
+    float32x4_t v = vmulq_f32(vmulq_f32(zf, zf), vsubq_f32(three, vmulq_f32(two, zf)));
+    float32x4_t iu = vsubq_f32(onef, u);
+    float32x4_t iv = vsubq_f32(onef, v);
+
+    float32x4_t r = vmulq_f32(vmulq_f32(a, iu), iv);
+    r = vaddq_f32(r, vmulq_f32(vmulq_f32(b, u), iv));
+    r = vaddq_f32(r, vmulq_f32(vmulq_f32(c, iu), v));
+    r = vaddq_f32(r, vmulq_f32(vmulq_f32(d, u), v));
+    return r;
+}
+
+static inline void terrainHeightBlock(const float* xs, const float* zs, float* out) {
+    float32x4_t scale = vdupq_n_f32(0.02f);
+    float32x4_t x1 = vmulq_f32(vld1q_f32(xs), scale);
+    float32x4_t z1 = vmulq_f32(vld1q_f32(zs), scale);
+    float32x4_t x2 = vmulq_f32(x1, vdupq_n_f32(2.0f)), z2 = vmulq_f32(z1, vdupq_n_f32(2.0f));
+    float32x4_t x4 = vmulq_f32(x1, vdupq_n_f32(4.0f)), z4 = vmulq_f32(z1, vdupq_n_f32(4.0f));
+    float32x4_t h = vmulq_f32(noise4(x1, z1), vdupq_n_f32(5.0f));
+    h = vaddq_f32(h, vmulq_f32(noise4(x2, z2), vdupq_n_f32(2.0f)));
+    h = vaddq_f32(h, vmulq_f32(noise4(x4, z4), vdupq_n_f32(0.5f)));
+    vst1q_f32(out, h);
+}
+
+static size_t terrainHeightBatchNeon(const float* xs, const float* zs, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) terrainHeightBlock(xs + i, zs + i, out + i);
+    return i;
+}
+
+#endif
+
+// ---- Runtime dispatch ----
+
+static bool cpuHasAvx2() {
+#if !GTA7_AVX2_KERNEL
+    return false;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osSavesYmm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return osSavesYmm && (info[1] & (1 << 5));
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static TerrainKernel widestTerrainKernel() {
+    if (terrainKernelSupported(TERRAIN_KERNEL_AVX2)) return TERRAIN_KERNEL_AVX2;
+    if (terrainKernelSupported(TERRAIN_KERNEL_SSE2)) return TERRAIN_KERNEL_SSE2;
+    if (terrainKernelSupported(TERRAIN_KERNEL_NEON)) return TERRAIN_KERNEL_NEON;
+    return TERRAIN_KERNEL_SCALAR;
+}
+
+static const bool hasAvx2 = cpuHasAvx2();
+static TerrainKernel currentKernel = widestTerrainKernel();
+
+const char* terrainKernelName(TerrainKernel kernel) {
+    static const char* names[TERRAIN_KERNEL_COUNT] = {"scalar", "sse2", "avx2", "neon"};
+    return kernel >= 0 && kernel < TERRAIN_KERNEL_COUNT ? names[kernel] : "unknown";
+}
+
+bool terrainKernelSupported(TerrainKernel kernel) {
+    switch (kernel) {
+        case TERRAIN_KERNEL_SCALAR: return true;
+#if defined(TERRAIN_BASELINE_SSE2)
+        case TERRAIN_KERNEL_SSE2: return true;
+#endif
+#if defined(TERRAIN_BASELINE_NEON)
+        case TERRAIN_KERNEL_NEON: return true;
+#endif
+        case TERRAIN_KERNEL_AVX2: return hasAvx2;
+        default: return false;
+    }
+}
+
+TerrainKernel activeTerrainKernel() {
+    return currentKernel;
+}
+
+void setTerrainKernel(TerrainKernel kernel) {
+    if (terrainKernelSupported(kernel)) currentKernel = kernel;
+}
+
+void getTerrainHeightBatchWith(TerrainKernel kernel, const float* xs, const float* zs, float* out, size_t n) {
+    size_t i = 0;
+    if (terrainKernelSupported(kernel)) {
+        switch (kernel) {
+#if GTA7_AVX2_KERNEL
+            case TERRAIN_KERNEL_AVX2: i = terrainHeightBatchAvx2(xs, zs, out, n); break;
+#endif
+#if defined(TERRAIN_BASELINE_SSE2)
+            case TERRAIN_KERNEL_SSE2: i = terrainHeightBatchSse2(xs, zs, out, n); break;
+#endif
+#if defined(TERRAIN_BASELINE_NEON)
+            case TERRAIN_KERNEL_NEON: i = terrainHeightBatchNeon(xs, zs, out, n); break;
+#endif
+            default: break;
+        }
+    }
+    for (; i < n; i++) {
+        out[i] = getTerrainHeight(xs[i], zs[i]);
+    }
+}
+
+void getTerrainHeightBatch(const float* xs, const float* zs, float* out, size_t n) {
+    getTerrainHeightBatchWith(currentKernel, xs, zs, out, n);
+}
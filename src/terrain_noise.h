@@ -0,0 +1,34 @@
+#pragma once
+// Terrain height field: lattice noise, three octaves of it, and a batched
+// sampler with SIMD kernels picked at runtime for the CPU it runs on. Every
+// kernel is bit-identical to the scalar functions, so chunk meshes agree
+// with gameplay queries whichever one is active.
+
+#include <cstddef>
+
+// noise() is in [0, 1]: 5 + 2 + 0.5
+const float TERRAIN_MAX_HEIGHT = 7.5f;
+
+float noise(float x, float z);
+float getTerrainHeight(float x, float z);
+void getTerrainHeightBatch(const float* xs, const float* zs, float* out, size_t n);
+
+enum TerrainKernel {
+    TERRAIN_KERNEL_SCALAR,
+    TERRAIN_KERNEL_SSE2,
+    TERRAIN_KERNEL_AVX2,
+    TERRAIN_KERNEL_NEON,
+    TERRAIN_KERNEL_COUNT
+};
+
+const char* terrainKernelName(TerrainKernel kernel);
+bool terrainKernelSupported(TerrainKernel kernel);     // built in and the CPU runs it
+TerrainKernel activeTerrainKernel();                    // widest supported, unless overridden
+void setTerrainKernel(TerrainKernel kernel);            // ignored when unsupported
+
+// One specific kernel, for benchmarks and tests; scalar when unsupported
+void getTerrainHeightBatchWith(TerrainKernel kernel, const float* xs, const float* zs, float* out, size_t n);
+
+// The AVX2 kernel lives in its own translation unit built with AVX2 enabled.
+// It handles whole blocks of 8 and returns how many points it wrote.
+size_t terrainHeightBatchAvx2(const float* xs, const float* zs, float* out, size_t n);
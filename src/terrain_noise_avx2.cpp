@@ -0,0 +1,73 @@
+// AVX2 terrain kernel. This file alone is compiled with AVX2 enabled, and
+// it includes nothing but the intrinsics: any inline function shared with
+// other translation units could otherwise be emitted here with AVX2
+// instructions and picked by the linker for callers on older CPUs.
+
+#include <cstddef>
+
+#if GTA7_AVX2_KERNEL
+
+#include <immintrin.h>
+
+size_t terrainHeightBatchAvx2(const float* xs, const float* zs, float* out, size_t n);
+
+namespace {
+
+
+inline __m256 hashToUnit8(__m256i a, __m256i b) {
+    __m256i h = _mm256_add_epi32(_mm256_mullo_epi32(a, _mm256_set1_epi32(374761393)),
+                                 _mm256_mullo_epi32(b, _mm256_set1_epi32(668265263)));
+    h = _mm256_xor_si256(h, _mm256_srai_epi32(h, 13));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32(1274126177));
+    h = _mm256_and_si256(h, _mm256_set1_epi32(0x7fffffff));
+    return _mm256_div_ps(_mm256_cvtepi32_ps(h), _mm256_set1_ps((float)0x7fffffff));
+}
+
+inline __m256 noise8(__m256 x, __m256 z) {
+    __m256i xi = _mm256_cvttps_epi32(_mm256_floor_ps(x));
+    __m256i zi = _mm256_cvttps_epi32(_mm256_floor_ps(z));
+    __m256 xf = _mm256_sub_ps(x, _mm256_cvtepi32_ps(xi));
+    __m256 zf = _mm256_sub_ps(z, _mm256_cvtepi32_ps(zi));
+
+    __m256i one = _mm256_set1_epi32(1);
+    __m256i xi1 = _mm256_add_epi32(xi, one);
+    __m256i zi1 = _mm256_add_epi32(zi, one);
+    __m256 a = hashToUnit8(xi, zi);
+    __m256 b = hashToUnit8(xi1, zi);
+    __m256 c = hashToUnit8(xi, zi1);
+    __m256 d = hashToUnit8(xi1, zi1);
+
+    __m256 three = _mm256_set1_ps(3.0f), two = _mm256_set1_ps(2.0f), onef = _mm256_set1_ps(1.0f);
+    __m256 u = _mm256_mul_ps(_mm256_mul_ps(xf, xf), _mm256_sub_ps(three, _mm256_mul_ps(two, xf)));
+    __m256 v = _mm256_mul_ps(_mm256_mul_ps(zf, zf), _mm256_sub_ps(three, _mm256_mul_ps(two, zf)));
+    __m256 iu = _mm256_sub_ps(onef, u);
+    __m256 iv = _mm256_sub_ps(onef, v);
+
+    __m256 r = _mm256_mul_ps(_mm256_mul_ps(a, iu), iv);
+    r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_mul_ps(b, u), iv));
+    r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_mul_ps(c, iu), v));
+    r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_mul_ps(d, u), v));
+    return r;
+}
+
+inline void terrainHeightBlock(const float* xs, const float* zs, float* out) {
+    __m256 scale = _mm256_set1_ps(0.02f);
+    __m256 x1 = _mm256_mul_ps(_mm256_loadu_ps(xs), scale);
+    __m256 z1 = _mm256_mul_ps(_mm256_loadu_ps(zs), scale);
+    __m256 x2 = _mm256_mul_ps(x1, _mm256_set1_ps(2.0f)), z2 = _mm256_mul_ps(z1, _mm256_set1_ps(2.0f));
+    __m256 x4 = _mm256_mul_ps(x1, _mm256_set1_ps(4.0f)), z4 = _mm256_mul_ps(z1, _mm256_set1_ps(4.0f));
+    __m256 h = _mm256_mul_ps(noise8(x1, z1), _mm256_set1_ps(5.0f));
+    h = _mm256_add_ps(h, _mm256_mul_ps(noise8(x2, z2), _mm256_set1_ps(2.0f)));
+    h = _mm256_add_ps(h, _mm256_mul_ps(noise8(x4, z4), _mm256_set1_ps(0.5f)));
+    _mm256_storeu_ps(out, h);
+}
+
+}  // namespace
+
+size_t terrainHeightBatchAvx2(const float* xs, const float* zs, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) terrainHeightBlock(xs + i, zs + i, out + i);
+    return i;
+}
+
+#endif
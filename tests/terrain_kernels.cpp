@@ -0,0 +1,97 @@
+// Every terrain kernel this build and CPU support must give the same bits
+// as scalar getTerrainHeight(): chunk meshes, the heightfield fallback and
+// replays all depend on it. Checks scattered, negative and large
+// coordinates, lattice boundaries, and batch lengths and offsets that leave
+// SIMD tails.
+
+#include "terrain_noise.h"
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+static int failures = 0;
+
+static void check(TerrainKernel kernel, const char* set, const std::vector<float>& xs, const std::vector<float>& zs,
+                  size_t first, size_t n) {
+    std::vector<float> out(n + 1, -1.0f);
+    getTerrainHeightBatchWith(kernel, xs.data() + first, zs.data() + first, out.data(), n);
+    for (size_t i = 0; i < n; i++) {
+        float expected = getTerrainHeight(xs[first + i], zs[first + i]);
+        if (memcmp(&expected, &out[i], sizeof(float)) != 0) {
+            printf("FAIL %s/%s: point %zu of %zu at offset %zu, (%.9g, %.9g): %.9g, scalar %.9g\n",
+                   terrainKernelName(kernel), set, i, n, first, xs[first + i], zs[first + i], out[i], expected);
+            failures++;
+            return;
+        }
+    }
+    if (out[n] != -1.0f) {
+        printf("FAIL %s/%s: wrote past %zu points\n", terrainKernelName(kernel), set, n);
+        failures++;
+    }
+}
+
+int main() {
+    std::mt19937 gen(1337);
+    struct PointSet {
+        const char* name;
+        std::vector<float> xs, zs;
+    };
+    std::vector<PointSet> sets;
+    auto scatter = [&](const char* name, float range, size_t count) {
+        std::uniform_real_distribution<float> coord(-range, range);
+        PointSet s = {name, {}, {}};
+        for (size_t i = 0; i < count; i++) {
+            s.xs.push_back(coord(gen));
+            s.zs.push_back(coord(gen));
+        }
+        sets.push_back(s);
+    };
+    scatter("spawn_area", 100.0f, 1 << 16);
+    scatter("far", 1e5f, 1 << 16);
+    scatter("very_far", 1e7f, 1 << 14);
+
+    // Whole and half tile coordinates, so floor() lands exactly on lattice
+    // lines, including negative zero
+    PointSet lattice = {"lattice", {}, {}};
+    for (int z = -40; z <= 40; z++) {
+        for (int x = -40; x <= 40; x++) {
+            lattice.xs.push_back(x * 0.5f);
+            lattice.zs.push_back(z * 0.5f);
+        }
+    }
+    lattice.xs.push_back(-0.0f);
+    lattice.zs.push_back(-0.0f);
+    sets.push_back(lattice);
+
+    int kernels = 0;
+    for (int k = 0; k < TERRAIN_KERNEL_COUNT; k++) {
+        TerrainKernel kernel = (TerrainKernel)k;
+        if (!terrainKernelSupported(kernel)) continue;
+        kernels++;
+        for (const PointSet& s : sets) {
+            check(kernel, s.name, s.xs, s.zs, 0, s.xs.size());
+            // Short batches from odd offsets: every tail length up to two AVX2 blocks
+            for (size_t n = 0; n <= 17; n++) check(kernel, s.name, s.xs, s.zs, 3, n);
+            check(kernel, s.name, s.xs, s.zs, 1, s.xs.size() - 6);
+        }
+    }
+
+    // The dispatched entry point, whichever kernel it picked
+    for (const PointSet& s : sets) {
+        std::vector<float> out(s.xs.size());
+        getTerrainHeightBatch(s.xs.data(), s.zs.data(), out.data(), s.xs.size());
+        for (size_t i = 0; i < out.size(); i++) {
+            float expected = getTerrainHeight(s.xs[i], s.zs[i]);
+            if (memcmp(&expected, &out[i], sizeof(float)) != 0) {
+                printf("FAIL getTerrainHeightBatch (%s)/%s: point %zu\n", terrainKernelName(activeTerrainKernel()), s.name, i);
+                failures++;
+                break;
+            }
+        }
+    }
+
+    printf("%d kernels checked (active: %s), %d failures\n", kernels, terrainKernelName(activeTerrainKernel()), failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+"""Diff two gta7_microbench JSON reports.
+
+    tools/compare_microbench.py baseline.json current.json [--threshold 5]
+
+Prints ns/op for every case in either report with the change in percent,
+plus allocations per op and IPC when both sides have them. Exits with 1
+if any case got slower than the threshold or started allocating, so it
+can gate a CI step.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        report = json.load(f)
+    return report, {r["name"]: r for r in report["results"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="percent slowdown counted as a regression (default 5)")
+    args = parser.parse_args()
+
+    base_report, base = load(args.baseline)
+    cur_report, cur = load(args.current)
+    if base_report.get("terrain_kernel") != cur_report.get("terrain_kernel"):
+        print("note: terrain kernel differs (%s vs %s)"
+              % (base_report.get("terrain_kernel"), cur_report.get("terrain_kernel")))
+
+    names = list(base) + [n for n in cur if n not in base]
+    width = max([len(n) for n in names] + [4])
+    print("%-*s %12s %12s %8s %10s %10s" % (width, "case", "base ns/op", "ns/op", "change", "allocs/op", "IPC"))
+
+    regressions = []
+    for name in names:
+        b, c = base.get(name), cur.get(name)
+        if b is None or c is None:
+            print("%-*s %12s %12s" % (width, name,
+                                      "%.2f" % b["ns_per_op"] if b else "-",
+                                      "%.2f" % c["ns_per_op"] if c else "-"))
+            continue
+        change = (c["ns_per_op"] / b["ns_per_op"] - 1.0) * 100.0 if b["ns_per_op"] > 0 else 0.0
+        ipc = "-"
+        if b.get("ipc") is not None and c.get("ipc") is not None:
+            ipc = "%.2f>%.2f" % (b["ipc"], c["ipc"])
+        flag = ""
+        if change > args.threshold:
+            flag = "  SLOWER"
+            regressions.append(name)
+        elif b["allocs_per_op"] == 0 and c["allocs_per_op"] > 0:
+            flag = "  ALLOCATES"
+            regressions.append(name)
+        elif change < -args.threshold:
+            flag = "  faster"
+        print("%-*s %12.2f %12.2f %+7.1f%% %10.4f %10s%s"
+              % (width, name, b["ns_per_op"], c["ns_per_op"], change, c["allocs_per_op"], ipc, flag))
+
+    if regressions:
+        print("\n%d regression(s) beyond %.1f%%: %s" % (len(regressions), args.threshold, ", ".join(regressions)))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())